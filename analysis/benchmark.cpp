@@ -1,8 +1,14 @@
 #include "include/wfa.hpp"
 #include "include/wfa_simd.hpp"
+#include "include/wfa_bidirectional.hpp"
+#include "include/wfa_piggyback.hpp"
+#include "include/wfa_batch.hpp"
+#include "include/wfa_parallel.hpp"
+#include "include/wfa_linear.hpp"
 #include "include/naive.hpp"
 #include "bindings/cpp/WFAligner.hpp"
 #include "include/data_gen.hpp"
+#include "perf_counters.hpp"
 #include "fmt/format.h"
 #include "fmt/chrono.h"
 #include <chrono>
@@ -25,22 +31,44 @@ int main(int argc, char* argv[]) {
     int o = std::stoi(argv[5]);
     int e = std::stoi(argv[6]);
 
-    // Generate sequences
-    auto sequences = wfa::modify_sequences(sequence_length, num_sequences, error_rate);
+    // Generate sequences, with the errors split evenly between mismatches, insertions and deletions
+    auto sequences = wfa::generate_pairs(wfa::error_model(sequence_length, error_rate), num_sequences).load();
+    uint64_t cells = 0;
+    for (const auto& pair : sequences) {
+        cells += static_cast<uint64_t>(pair.first.size()) * pair.second.size();
+    }
+
+    // Hardware counters around each run, printed after its time where perf_event_open is available
+    perf_counters_t perf;
+    perf_sample_t sample;
+    if (!perf.available()) {
+        fmt::println("Hardware counters unavailable, timing only");
+    }
+    // Set WFA_SIMD_LEVEL to time the narrower extend kernels on the same machine
+    fmt::println("Extend kernels: {} (CPU supports {})", wfa::simd_level_name(wfa::simd_level()), wfa::simd_level_name(wfa::detect_simd_level()));
 
-    // Benchmark Naive
+    // Benchmark Naive, which needs a full DP matrix and so is skipped for long reads
     auto start = std::chrono::system_clock::now();
+    auto end = start;
+    perf.start();
     wfa::wavefront_arena_t arena1;
-    for (const auto& pair : sequences) {
-        const std::string& a = pair.first;
-        const std::string& b = pair.second;
-        wfa::naive(a, b, x, o, e);
+    if (sequence_length <= 5000) {
+        for (const auto& pair : sequences) {
+            const std::string& a = pair.first;
+            const std::string& b = pair.second;
+            wfa::naive(a, b, x, o, e);
+        }
+        end = std::chrono::system_clock::now();
+        sample = perf.stop();
+        fmt::println("Naive: {:%T}{}", end - start, perf_summary(sample, cells));
+    }
+    else {
+        fmt::println("Naive: skipped");
     }
-    auto end = std::chrono::system_clock::now();
-    fmt::println("Naive: {:%T}", end - start);
 
 
     // Benchmark Wavefront
+    perf.start();
     start = std::chrono::system_clock::now();
     for (const auto& pair : sequences) {
         const std::string& a = pair.first;
@@ -48,9 +76,11 @@ int main(int argc, char* argv[]) {
         wfa::wavefront(a, b, x, o, e, arena1);
     }
     end = std::chrono::system_clock::now();
-    fmt::println("Wavefront: {:%T}", end - start);
+    sample = perf.stop();
+    fmt::println("Wavefront: {:%T}{}", end - start, perf_summary(sample, cells));
 
     // Benchmark Wavefront SIMD
+    perf.start();
     start = std::chrono::system_clock::now();
     wfa::wavefront_arena_t arena2;
     for (const auto& pair : sequences) {
@@ -59,10 +89,122 @@ int main(int argc, char* argv[]) {
         wfa::wavefront_simd(a, b, x, o, e, arena2);
     }
     end = std::chrono::system_clock::now();
-    fmt::println("Wavefront SIMD: {:%T}", end - start);
+    sample = perf.stop();
+    fmt::println("Wavefront SIMD: {:%T}{}", end - start, perf_summary(sample, cells));
+
+    // Benchmark the single component engines. They score differently from gap-affine, using x and e as the mismatch and per base gap costs
+    perf.start();
+    start = std::chrono::system_clock::now();
+    for (const auto& pair : sequences) {
+        wfa::wavefront_linear_simd(pair.first, pair.second, x, e, arena2);
+    }
+    end = std::chrono::system_clock::now();
+    sample = perf.stop();
+    fmt::println("Wavefront SIMD Linear: {:%T}{}", end - start, perf_summary(sample, cells));
+
+    perf.start();
+    start = std::chrono::system_clock::now();
+    for (const auto& pair : sequences) {
+        wfa::wavefront_edit_simd(pair.first, pair.second, arena2);
+    }
+    end = std::chrono::system_clock::now();
+    sample = perf.stop();
+    fmt::println("Wavefront SIMD Edit: {:%T}{}", end - start, perf_summary(sample, cells));
+
+    // Benchmark Wavefront SIMD on 2-bit packed sequences. Packing is done up front, as it would be when reading the sequences in
+    std::vector<std::pair<wfa::packed_sequence_t, wfa::packed_sequence_t>> packed;
+    packed.reserve(sequences.size());
+    for (const auto& pair : sequences) {
+        packed.emplace_back(wfa::packed_sequence_t(pair.first), wfa::packed_sequence_t(pair.second));
+    }
+    perf.start();
+    start = std::chrono::system_clock::now();
+    for (const auto& pair : packed) {
+        wfa::wavefront_simd(pair.first, pair.second, x, o, e, arena2);
+    }
+    end = std::chrono::system_clock::now();
+    sample = perf.stop();
+    fmt::println("Wavefront SIMD Packed: {:%T}{}", end - start, perf_summary(sample, cells));
+
+    // Benchmark the batch engine, which aligns one pair per vector lane
+    wfa::batch_arena_t batch_arena;
+    std::vector<int32_t> scores(sequences.size());
+    perf.start();
+    start = std::chrono::system_clock::now();
+    wfa::wavefront_batch(sequences, x, o, e, batch_arena, scores);
+    end = std::chrono::system_clock::now();
+    sample = perf.stop();
+    fmt::println("Wavefront Batch: {:%T}{}", end - start, perf_summary(sample, cells));
+
+    // Benchmark Wavefront SIMD spread over every hardware thread
+    wfa::parallel_arena_t parallel_arena;
+    perf.start();
+    start = std::chrono::system_clock::now();
+    wfa::wavefront_parallel(sequences, x, o, e, parallel_arena, scores);
+    end = std::chrono::system_clock::now();
+    sample = perf.stop();
+    fmt::println("Wavefront SIMD Parallel ({} threads): {:%T}{}", parallel_arena.arenas.size(), end - start, perf_summary(sample, cells));
+
+    // Benchmark Wavefront with traceback, reusing one cigar buffer for every pair
+    std::string cigar;
+    perf.start();
+    start = std::chrono::system_clock::now();
+    for (const auto& pair : sequences) {
+        const std::string& a = pair.first;
+        const std::string& b = pair.second;
+        wfa::wavefront(a, b, x, o, e, arena1, cigar);
+    }
+    end = std::chrono::system_clock::now();
+    sample = perf.stop();
+    fmt::println("Wavefront CIGAR: {:%T}{}", end - start, perf_summary(sample, cells));
+
+    // Benchmark Wavefront SIMD with traceback
+    perf.start();
+    start = std::chrono::system_clock::now();
+    for (const auto& pair : sequences) {
+        const std::string& a = pair.first;
+        const std::string& b = pair.second;
+        wfa::wavefront_simd(a, b, x, o, e, arena2, cigar);
+    }
+    end = std::chrono::system_clock::now();
+    sample = perf.stop();
+    fmt::println("Wavefront SIMD CIGAR: {:%T}{}", end - start, perf_summary(sample, cells));
+
+    // Benchmark bidirectional Wavefront with traceback
+    wfa::bidirectional_arena_t arena3;
+    perf.start();
+    start = std::chrono::system_clock::now();
+    for (const auto& pair : sequences) {
+        const std::string& a = pair.first;
+        const std::string& b = pair.second;
+        wfa::wavefront_bidirectional(a, b, x, o, e, arena3, cigar);
+    }
+    end = std::chrono::system_clock::now();
+    sample = perf.stop();
+    fmt::println("Wavefront Bidirectional CIGAR: {:%T}{}", end - start, perf_summary(sample, cells));
+
+    // Benchmark Wavefront SIMD with piggybacked traceback blocks
+    wfa::piggyback_arena_t arena4;
+    perf.start();
+    start = std::chrono::system_clock::now();
+    for (const auto& pair : sequences) {
+        const std::string& a = pair.first;
+        const std::string& b = pair.second;
+        wfa::wavefront_simd_piggyback(a, b, x, o, e, arena4, cigar);
+    }
+    end = std::chrono::system_clock::now();
+    sample = perf.stop();
+    fmt::println("Wavefront SIMD Piggyback CIGAR: {:%T}{}", end - start, perf_summary(sample, cells));
+
+    // Arenas only grow, so their capacity is the peak wavefront memory of each approach
+    size_t arena_peak = arena2.capacity() * sizeof(int32_t);
+    size_t bidirectional_peak = (arena3.forward.capacity() + arena3.reverse.capacity()) * sizeof(int32_t);
+    size_t piggyback_peak = arena4.wavefronts.capacity() * sizeof(int32_t) + arena4.blocks.capacity() * sizeof(wfa::backtrace_block_t);
+    fmt::println("Peak arena memory: Wavefront SIMD {} KiB, Wavefront Bidirectional {} KiB, Wavefront SIMD Piggyback {} KiB", arena_peak / 1024, bidirectional_peak / 1024, piggyback_peak / 1024);
 
-    // Benchmark WFA2-lib
+    // Benchmark WFA2-lib (full alignment, comparable to the CIGAR runs above)
     wfa::WFAlignerGapAffine aligner(x, o, e, wfa::WFAligner::Alignment, wfa::WFAligner::MemoryHigh);
+    perf.start();
     start = std::chrono::system_clock::now();
     for (const auto& pair : sequences) {
         const std::string& a = pair.first;
@@ -71,6 +213,7 @@ int main(int argc, char* argv[]) {
         aligner.alignEnd2End(a, b);
     }
     end = std::chrono::system_clock::now();
-    fmt::println("WFA2-lib: {:%T}", end - start);
+    sample = perf.stop();
+    fmt::println("WFA2-lib: {:%T}{}", end - start, perf_summary(sample, cells));
     return 0;
 }
@@ -4,56 +4,131 @@
 #include <vector>
 #include <chrono>
 #include <iomanip>
+#include <algorithm>
+#include <map>
+#include <stdexcept>
 #include "include/wfa.hpp"
 #include "include/wfa_simd.hpp"
+#include "include/wfa_batch.hpp"
+#include "include/wfa_parallel.hpp"
 #include "include/naive.hpp"
 #include "bindings/cpp/WFAligner.hpp"
 #include "include/data_gen.hpp"
+#include "include/pair_dataset.hpp"
+#include "perf_counters.hpp"
+
+// Generates the pairs for a set of parameters once and keeps them in a dataset file, so every algorithm, and every later run, aligns byte-identical inputs.
+// The errors are split evenly between mismatches, insertions and deletions (wfa::error_model), drawn from a fixed seed, so the files can be regenerated exactly
+const wfa::pair_dataset_t& load_dataset(int sequence_length, int num_sequences, double error_rate) {
+    static std::map<std::string, wfa::pair_dataset_t> datasets;
+    std::string path = "reads_" + std::to_string(sequence_length) + "_" + std::to_string(num_sequences) + "_" + std::to_string(error_rate) + ".wfad";
+    auto it = datasets.find(path);
+    if (it == datasets.end()) {
+        if (!wfa::pair_dataset_t(path).is_open()) {
+            wfa::write_dataset(path, wfa::generate_pairs(wfa::error_model(sequence_length, error_rate), num_sequences));
+        }
+        it = datasets.try_emplace(path, path).first;
+        if (!it->second.is_open()) {
+            throw std::runtime_error("Failed to write dataset: " + path);
+        }
+    }
+    return it->second;
+}
+
+// The wall-clock time of one run in milliseconds, the hardware counters around it where perf_event_open is available, and the DP cells it covered
+struct alignment_run_t {
+    double time;
+    perf_sample_t counters;
+    uint64_t cells;
+};
 
 // Function to execute and benchmark algorithms
-double run_alignment(double error_rate, int sequence_length, int num_sequences,
+alignment_run_t run_alignment(double error_rate, int sequence_length, int num_sequences,
     int mismatch_penalty, int gap_opening_cost, int gap_extension_cost,
     const std::string& algorithm) {
-    // Generate sequences
-    auto sequences = wfa::modify_sequences(sequence_length, num_sequences, error_rate);
+    const wfa::pair_dataset_t& sequences = load_dataset(sequence_length, num_sequences, error_rate);
+    // The batch engines take owned strings, copied out before the clock starts
+    std::vector<std::pair<std::string, std::string>> owned;
+    if (algorithm == "Wavefront Batch" || algorithm == "Wavefront SIMD Parallel") {
+        owned = sequences.load();
+    }
 
+    uint64_t cells = 0;
+    for (size_t i = 0; i < sequences.size(); ++i) {
+        auto [a, b] = sequences[i];
+        cells += static_cast<uint64_t>(a.size()) * b.size();
+    }
+
+    static perf_counters_t perf;
+    perf.start();
     auto start = std::chrono::high_resolution_clock::now();
     if (algorithm == "Naive") {
-        for (const auto& pair : sequences) {
-            const std::string& a = pair.first;
-            const std::string& b = pair.second;
+        for (size_t i = 0; i < sequences.size(); ++i) {
+            auto [a, b] = sequences[i];
             wfa::naive(a, b, mismatch_penalty, gap_opening_cost, gap_extension_cost);
         }
     }
     else if (algorithm == "Wavefront") {
         wfa::wavefront_arena_t arena;
-        for (const auto& pair : sequences) {
-            const std::string& a = pair.first;
-            const std::string& b = pair.second;
+        for (size_t i = 0; i < sequences.size(); ++i) {
+            auto [a, b] = sequences[i];
             wfa::wavefront(a, b, mismatch_penalty, gap_opening_cost, gap_extension_cost, arena);
         }
     }
     else if (algorithm == "Wavefront SIMD") {
         wfa::wavefront_arena_t arena;
-        for (const auto& pair : sequences) {
-            const std::string& a = pair.first;
-            const std::string& b = pair.second;
+        for (size_t i = 0; i < sequences.size(); ++i) {
+            auto [a, b] = sequences[i];
             wfa::wavefront_simd(a, b, mismatch_penalty, gap_opening_cost, gap_extension_cost, arena);
         }
     }
+    else if (algorithm == "Wavefront Batch") {
+        wfa::batch_arena_t arena;
+        std::vector<int32_t> scores(owned.size());
+        wfa::wavefront_batch(owned, mismatch_penalty, gap_opening_cost, gap_extension_cost, arena, scores);
+    }
+    else if (algorithm == "Wavefront SIMD Parallel") {
+        wfa::parallel_arena_t arena;
+        std::vector<int32_t> scores(owned.size());
+        wfa::wavefront_parallel(owned, mismatch_penalty, gap_opening_cost, gap_extension_cost, arena, scores);
+    }
+    else if (algorithm == "Wavefront Adaptive") {
+        wfa::wavefront_arena_t arena;
+        wfa::reduction_t reduction;
+        for (size_t i = 0; i < sequences.size(); ++i) {
+            auto [a, b] = sequences[i];
+            wfa::wavefront(a, b, mismatch_penalty, gap_opening_cost, gap_extension_cost, arena, reduction);
+        }
+    }
+    else if (algorithm == "Wavefront SIMD Adaptive") {
+        wfa::wavefront_arena_t arena;
+        wfa::reduction_t reduction;
+        for (size_t i = 0; i < sequences.size(); ++i) {
+            auto [a, b] = sequences[i];
+            wfa::wavefront_simd(a, b, mismatch_penalty, gap_opening_cost, gap_extension_cost, arena, reduction);
+        }
+    }
     else if (algorithm == "WFA2-lib") {
         wfa::WFAlignerGapAffine aligner(mismatch_penalty, gap_opening_cost, gap_extension_cost,
             wfa::WFAligner::Alignment, wfa::WFAligner::MemoryHigh);
-        for (const auto& pair : sequences) {
-            const std::string& a = pair.first;
-            const std::string& b = pair.second;
-            aligner.alignEnd2End(a, b);
+        for (size_t i = 0; i < sequences.size(); ++i) {
+            auto [a, b] = sequences[i];
+            aligner.alignEnd2End(a.data(), static_cast<int>(a.size()), b.data(), static_cast<int>(b.size()));
         }
     }
     auto end = std::chrono::high_resolution_clock::now();
+    perf_sample_t counters = perf.stop();
 
     // Calculate and return elapsed time in milliseconds
-    return std::chrono::duration<double, std::milli>(end - start).count();
+    return { std::chrono::duration<double, std::milli>(end - start).count(), counters, cells };
+}
+
+// A row of exp_results.csv: the run's parameters and time, followed by its hardware counters
+std::vector<std::string> result_row(std::vector<std::string> row, const alignment_run_t& run) {
+    row.push_back(std::to_string(run.time));
+    std::vector<std::string> counters = perf_csv_columns(run.counters, run.cells);
+    row.insert(row.end(), counters.begin(), counters.end());
+    return row;
 }
 
 // Function to write data to the CSV file
@@ -84,11 +159,11 @@ void experiment_vary_error_rate(const std::string& output_csv) {
     int sequence_length = 250;
     std::vector<double> error_rates = { 0.01, 0.05, 0.1, 0.2, 0.3 };
 
-    std::vector<std::string> algorithms = { /*"Naive", */"Wavefront", "Wavefront SIMD", "WFA2-lib" };
+    std::vector<std::string> algorithms = { /*"Naive", */"Wavefront", "Wavefront SIMD", "Wavefront Batch", "WFA2-lib" };
     for (double error_rate : error_rates) {
         for (const auto& algorithm : algorithms) {
-            double avg_time = run_alignment(error_rate, sequence_length, num_samples, mismatch_penalty, gap_opening_cost, gap_extension_cost, algorithm);
-            write_to_csv(output_csv, { {algorithm, "Error v Time", std::to_string(num_samples), std::to_string(sequence_length), std::to_string(error_rate), std::to_string(mismatch_penalty), std::to_string(gap_opening_cost), std::to_string(gap_extension_cost), std::to_string(avg_time)} });
+            alignment_run_t run = run_alignment(error_rate, sequence_length, num_samples, mismatch_penalty, gap_opening_cost, gap_extension_cost, algorithm);
+            write_to_csv(output_csv, { result_row({algorithm, "Error v Time", std::to_string(num_samples), std::to_string(sequence_length), std::to_string(error_rate), std::to_string(mismatch_penalty), std::to_string(gap_opening_cost), std::to_string(gap_extension_cost)}, run) });
         }
     }
 }
@@ -104,8 +179,8 @@ void experiment_vary_sequence_length(const std::string& output_csv) {
     std::vector<std::string> algorithms = { /*"Naive",*/ "Wavefront", "Wavefront SIMD", "WFA2-lib" };
     for (int sequence_length : sequence_lengths) {
         for (const auto& algorithm : algorithms) {
-            double avg_time = run_alignment(error_rate, sequence_length, num_samples, mismatch_penalty, gap_opening_cost, gap_extension_cost, algorithm);
-            write_to_csv(output_csv, { {algorithm, "Sequence Length v Time", std::to_string(num_samples), std::to_string(sequence_length), std::to_string(error_rate), std::to_string(mismatch_penalty), std::to_string(gap_opening_cost), std::to_string(gap_extension_cost), std::to_string(avg_time)} });
+            alignment_run_t run = run_alignment(error_rate, sequence_length, num_samples, mismatch_penalty, gap_opening_cost, gap_extension_cost, algorithm);
+            write_to_csv(output_csv, { result_row({algorithm, "Sequence Length v Time", std::to_string(num_samples), std::to_string(sequence_length), std::to_string(error_rate), std::to_string(mismatch_penalty), std::to_string(gap_opening_cost), std::to_string(gap_extension_cost)}, run) });
         }
     }
 }
@@ -121,8 +196,8 @@ void experiment_vary_gap_opening(const std::string& output_csv) {
     std::vector<std::string> algorithms = { /*"Naive",*/ "Wavefront", "Wavefront SIMD", "WFA2-lib" };
     for (int gap_opening_cost : gap_opening_costs) {
         for (const auto& algorithm : algorithms) {
-            double avg_time = run_alignment(error_rate, sequence_length, num_samples, mismatch_penalty, gap_opening_cost, gap_extension_cost, algorithm);
-            write_to_csv(output_csv, { {algorithm, "Gap Opening v Time", std::to_string(num_samples), std::to_string(sequence_length), std::to_string(error_rate), std::to_string(mismatch_penalty), std::to_string(gap_opening_cost), std::to_string(gap_extension_cost), std::to_string(avg_time)} });
+            alignment_run_t run = run_alignment(error_rate, sequence_length, num_samples, mismatch_penalty, gap_opening_cost, gap_extension_cost, algorithm);
+            write_to_csv(output_csv, { result_row({algorithm, "Gap Opening v Time", std::to_string(num_samples), std::to_string(sequence_length), std::to_string(error_rate), std::to_string(mismatch_penalty), std::to_string(gap_opening_cost), std::to_string(gap_extension_cost)}, run) });
         }
     }
 }
@@ -138,8 +213,8 @@ void experiment_vary_gap_extension(const std::string& output_csv) {
     std::vector<std::string> algorithms = { "Naive", "Wavefront", "Wavefront SIMD", "WFA2-lib" };
     for (int gap_extension_cost : gap_extension_costs) {
         for (const auto& algorithm : algorithms) {
-            double avg_time = run_alignment(error_rate, sequence_length, num_samples, mismatch_penalty, gap_opening_cost, gap_extension_cost, algorithm);
-            write_to_csv(output_csv, { {algorithm, "Gap Extension v Time", std::to_string(num_samples), std::to_string(sequence_length), std::to_string(error_rate), std::to_string(mismatch_penalty), std::to_string(gap_opening_cost), std::to_string(gap_extension_cost), std::to_string(avg_time)} });
+            alignment_run_t run = run_alignment(error_rate, sequence_length, num_samples, mismatch_penalty, gap_opening_cost, gap_extension_cost, algorithm);
+            write_to_csv(output_csv, { result_row({algorithm, "Gap Extension v Time", std::to_string(num_samples), std::to_string(sequence_length), std::to_string(error_rate), std::to_string(mismatch_penalty), std::to_string(gap_opening_cost), std::to_string(gap_extension_cost)}, run) });
         }
     }
 }
@@ -155,8 +230,8 @@ void experiment_vary_mismatch_penalty(const std::string& output_csv) {
     std::vector<std::string> algorithms = { "Naive", "Wavefront", "Wavefront SIMD", "WFA2-lib" };
     for (int mismatch_penalty : mismatch_penalties) {
         for (const auto& algorithm : algorithms) {
-            double avg_time = run_alignment(error_rate, sequence_length, num_samples, mismatch_penalty, gap_opening_cost, gap_extension_cost, algorithm);
-            write_to_csv(output_csv, { {algorithm, "Mismatch Penalty v Time", std::to_string(num_samples), std::to_string(sequence_length), std::to_string(error_rate), std::to_string(mismatch_penalty), std::to_string(gap_opening_cost), std::to_string(gap_extension_cost), std::to_string(avg_time)} });
+            alignment_run_t run = run_alignment(error_rate, sequence_length, num_samples, mismatch_penalty, gap_opening_cost, gap_extension_cost, algorithm);
+            write_to_csv(output_csv, { result_row({algorithm, "Mismatch Penalty v Time", std::to_string(num_samples), std::to_string(sequence_length), std::to_string(error_rate), std::to_string(mismatch_penalty), std::to_string(gap_opening_cost), std::to_string(gap_extension_cost)}, run) });
         }
     }
 }
@@ -174,8 +249,8 @@ void experiment_joint_error_length(const std::string& output_csv) {
     for (int sequence_length : sequence_lengths) {
         for (double error_rate : error_rates) {
             for (const auto& algorithm : algorithms) {
-                double avg_time = run_alignment(error_rate, sequence_length, num_samples, mismatch_penalty, gap_opening_cost, gap_extension_cost, algorithm);
-                write_to_csv(output_csv, { {algorithm, "Joint Error & Length", std::to_string(num_samples), std::to_string(sequence_length), std::to_string(error_rate), std::to_string(mismatch_penalty), std::to_string(gap_opening_cost), std::to_string(gap_extension_cost), std::to_string(avg_time)} });
+                alignment_run_t run = run_alignment(error_rate, sequence_length, num_samples, mismatch_penalty, gap_opening_cost, gap_extension_cost, algorithm);
+                write_to_csv(output_csv, { result_row({algorithm, "Joint Error & Length", std::to_string(num_samples), std::to_string(sequence_length), std::to_string(error_rate), std::to_string(mismatch_penalty), std::to_string(gap_opening_cost), std::to_string(gap_extension_cost)}, run) });
             }
         }
     }
@@ -194,8 +269,8 @@ void experiment_interaction_gap_costs(const std::string& output_csv) {
     for (int gap_opening_cost : gap_opening_costs) {
         for (int gap_extension_cost : gap_extension_costs) {
             for (const auto& algorithm : algorithms) {
-                double avg_time = run_alignment(error_rate, sequence_length, num_samples, mismatch_penalty, gap_opening_cost, gap_extension_cost, algorithm);
-                write_to_csv(output_csv, { {algorithm, "Gap Costs Interaction", std::to_string(num_samples), std::to_string(sequence_length), std::to_string(error_rate), std::to_string(mismatch_penalty), std::to_string(gap_opening_cost), std::to_string(gap_extension_cost), std::to_string(avg_time)} });
+                alignment_run_t run = run_alignment(error_rate, sequence_length, num_samples, mismatch_penalty, gap_opening_cost, gap_extension_cost, algorithm);
+                write_to_csv(output_csv, { result_row({algorithm, "Gap Costs Interaction", std::to_string(num_samples), std::to_string(sequence_length), std::to_string(error_rate), std::to_string(mismatch_penalty), std::to_string(gap_opening_cost), std::to_string(gap_extension_cost)}, run) });
             }
         }
     }
@@ -215,8 +290,8 @@ void experiment_sensitivity_analysis(const std::string& output_csv) {
         for (int gap_opening_cost : gap_opening_costs) {
             for (int gap_extension_cost : gap_extension_costs) {
                 for (const auto& algorithm : algorithms) {
-                    double avg_time = run_alignment(error_rate, sequence_length, num_samples, mismatch_penalty, gap_opening_cost, gap_extension_cost, algorithm);
-                    write_to_csv(output_csv, { {algorithm, "Sensitivity Analysis", std::to_string(num_samples), std::to_string(sequence_length), std::to_string(error_rate), std::to_string(mismatch_penalty), std::to_string(gap_opening_cost), std::to_string(gap_extension_cost), std::to_string(avg_time)} });
+                    alignment_run_t run = run_alignment(error_rate, sequence_length, num_samples, mismatch_penalty, gap_opening_cost, gap_extension_cost, algorithm);
+                    write_to_csv(output_csv, { result_row({algorithm, "Sensitivity Analysis", std::to_string(num_samples), std::to_string(sequence_length), std::to_string(error_rate), std::to_string(mismatch_penalty), std::to_string(gap_opening_cost), std::to_string(gap_extension_cost)}, run) });
                 }
             }
         }
@@ -236,8 +311,8 @@ void experiment_error_rate_complexity(const std::string& output_csv) {
     for (double error_rate : error_rates) {
         for (int gap_opening_cost : gap_opening_costs) {
             for (const auto& algorithm : algorithms) {
-                double avg_time = run_alignment(error_rate, sequence_length, num_samples, mismatch_penalty, gap_opening_cost, gap_extension_cost, algorithm);
-                write_to_csv(output_csv, { {algorithm, "Error Rate & Complexity", std::to_string(num_samples), std::to_string(sequence_length), std::to_string(error_rate), std::to_string(mismatch_penalty), std::to_string(gap_opening_cost), std::to_string(gap_extension_cost), std::to_string(avg_time)} });
+                alignment_run_t run = run_alignment(error_rate, sequence_length, num_samples, mismatch_penalty, gap_opening_cost, gap_extension_cost, algorithm);
+                write_to_csv(output_csv, { result_row({algorithm, "Error Rate & Complexity", std::to_string(num_samples), std::to_string(sequence_length), std::to_string(error_rate), std::to_string(mismatch_penalty), std::to_string(gap_opening_cost), std::to_string(gap_extension_cost)}, run) });
             }
         }
     }
@@ -256,13 +331,63 @@ void experiment_length_gap_penalties(const std::string& output_csv) {
     for (int sequence_length : sequence_lengths) {
         for (int gap_opening_cost : gap_opening_costs) {
             for (const auto& algorithm : algorithms) {
-                double avg_time = run_alignment(error_rate, sequence_length, num_samples, mismatch_penalty, gap_opening_cost, gap_extension_cost, algorithm);
-                write_to_csv(output_csv, { {algorithm, "Length & Gap Penalties", std::to_string(num_samples), std::to_string(sequence_length), std::to_string(error_rate), std::to_string(mismatch_penalty), std::to_string(gap_opening_cost), std::to_string(gap_extension_cost), std::to_string(avg_time)} });
+                alignment_run_t run = run_alignment(error_rate, sequence_length, num_samples, mismatch_penalty, gap_opening_cost, gap_extension_cost, algorithm);
+                write_to_csv(output_csv, { result_row({algorithm, "Length & Gap Penalties", std::to_string(num_samples), std::to_string(sequence_length), std::to_string(error_rate), std::to_string(mismatch_penalty), std::to_string(gap_opening_cost), std::to_string(gap_extension_cost)}, run) });
             }
         }
     }
 }
 
+// Experiment: Adaptive Wavefront Reduction, timed against the exact SIMD wavefront and scored against naive
+void experiment_adaptive_reduction(const std::string& output_csv) {
+    int mismatch_penalty = 4;
+    int gap_opening_cost = 6;
+    int gap_extension_cost = 2;
+    int num_samples = 500;
+    int sequence_length = 1000;
+    std::vector<double> error_rates = { 0.05, 0.1, 0.2, 0.3 };
+    wfa::reduction_t reduction;
+
+    for (double error_rate : error_rates) {
+        auto sequences = load_dataset(sequence_length, num_samples, error_rate).load();
+        std::vector<int32_t> adaptive_scores(sequences.size());
+        wfa::wavefront_arena_t arena;
+
+        auto start = std::chrono::high_resolution_clock::now();
+        for (const auto& pair : sequences) {
+            wfa::wavefront_simd(pair.first, pair.second, mismatch_penalty, gap_opening_cost, gap_extension_cost, arena);
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        double exact_time = std::chrono::duration<double, std::milli>(end - start).count();
+
+        start = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < sequences.size(); ++i) {
+            adaptive_scores[i] = wfa::wavefront_simd(sequences[i].first, sequences[i].second, mismatch_penalty, gap_opening_cost, gap_extension_cost, arena, reduction);
+        }
+        end = std::chrono::high_resolution_clock::now();
+        double adaptive_time = std::chrono::duration<double, std::milli>(end - start).count();
+
+        // Scores are negative, so a worse adaptive score is a lower one
+        int mismatched = 0;
+        double total_loss = 0.0;
+        for (size_t i = 0; i < sequences.size(); ++i) {
+            int32_t reference = wfa::naive(sequences[i].first, sequences[i].second, mismatch_penalty, gap_opening_cost, gap_extension_cost);
+            if (adaptive_scores[i] != reference) {
+                ++mismatched;
+                total_loss += static_cast<double>(reference - adaptive_scores[i]) / std::max(-reference, 1);
+            }
+        }
+        double speedup = exact_time / adaptive_time;
+        double mismatched_rate = static_cast<double>(mismatched) / sequences.size();
+        double mean_loss = total_loss / sequences.size();
+
+        std::cout << "  Error rate " << error_rate << ": speedup " << std::fixed << std::setprecision(2) << speedup
+            << "x, " << mismatched << "/" << sequences.size() << " scores differ from naive, mean score loss " << std::setprecision(4) << mean_loss * 100 << "%\n";
+        std::cout.unsetf(std::ios::floatfield);
+        write_to_csv(output_csv, { {"Wavefront SIMD Adaptive", "Adaptive Reduction", std::to_string(num_samples), std::to_string(sequence_length), std::to_string(error_rate), std::to_string(mismatch_penalty), std::to_string(gap_opening_cost), std::to_string(gap_extension_cost), std::to_string(adaptive_time), std::to_string(exact_time), std::to_string(speedup), std::to_string(mismatched_rate), std::to_string(mean_loss)} });
+    }
+}
+
 
 // Main function
 int main() {
@@ -275,9 +400,20 @@ int main() {
         return 1;
     }
 
-    csv_file << "Algorithm,Experiment,Sample Count,Sequence Length,Error Rate,Mismatch Penalty,Gap Opening Cost,Gap Extension Cost,Avg Time\n";
+    csv_file << "Algorithm,Experiment,Sample Count,Sequence Length,Error Rate,Mismatch Penalty,Gap Opening Cost,Gap Extension Cost,Avg Time," << perf_csv_header << "\n";
     csv_file.close();
 
+    // The adaptive reduction results have extra columns, so they get their own file
+    std::string adaptive_csv = "adaptive_results.csv";
+    std::ofstream adaptive_file(adaptive_csv);
+    if (!adaptive_file.is_open()) {
+        std::cerr << "Failed to open file: " << adaptive_csv << "\n";
+        return 1;
+    }
+
+    adaptive_file << "Algorithm,Experiment,Sample Count,Sequence Length,Error Rate,Mismatch Penalty,Gap Opening Cost,Gap Extension Cost,Avg Time,Exact Time,Speedup,Mismatched Scores,Mean Score Loss\n";
+    adaptive_file.close();
+
     try {
         // Run all experiments
         std::cout << "Running Experiment: Error Rate vs Time...\n";
@@ -310,7 +446,10 @@ int main() {
         std::cout << "Running Experiment: Combination of Sequence Length and Gap Penalties...\n";
         //experiment_length_gap_penalties(output_csv);
 
-        std::cout << "All experiments completed. Results written to: " << output_csv << "\n";
+        std::cout << "Running Experiment: Adaptive Wavefront Reduction...\n";
+        experiment_adaptive_reduction(adaptive_csv);
+
+        std::cout << "All experiments completed. Results written to: " << output_csv << " and " << adaptive_csv << "\n";
     }
     catch (const std::exception& e) {
         std::cerr << "An error occurred during execution: " << e.what() << "\n";
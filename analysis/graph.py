@@ -30,14 +30,15 @@ plt.rcParams['font.family'] = 'DejaVu Serif'  # Use a font similar to Computer M
 plt.rcParams['mathtext.fontset'] = 'cm'  # Use Computer Modern for math
 
 
-def plot_line(data, x, y, hue, title, x_label, y_label, output_file, sample_count, seq_length):
+def plot_line(data, x, y, hue, title, x_label, y_label, output_file, sample_count, seq_length, log_scale=True):
     """Generate a line plot with dynamic title."""
     plt.figure(figsize=(10, 6))
     sns.lineplot(data=data, x=x, y=y, hue=hue, marker="o")
     plt.title(f"{title}\n(Sample Count: {sample_count}, Sequence Length: {seq_length})")
     plt.xlabel(x_label)
     plt.ylabel(y_label)
-    plt.yscale("log")
+    if log_scale:
+        plt.yscale("log")
     plt.legend(title=hue)
     plt.tight_layout()
     plt.savefig(output_file)
@@ -194,6 +195,14 @@ experiments = {
     },
 }
 
+# Hardware counter columns experiment writes where perf_event_open is available, plotted for every line experiment that has them
+counters = {
+    "IPC": "Instructions Per Cycle",
+    "Instructions Per Cell": "Instructions Per DP Cell",
+    "Cache Miss Rate": "Cache Miss Rate",
+    "Branch Miss Rate": "Branch Miss Rate",
+}
+
 # Generate plots for each experiment
 for experiment, params in experiments.items():
     filtered_data = data[data["Experiment"] == experiment]
@@ -216,6 +225,22 @@ for experiment, params in experiments.items():
             sample_count=sample_count,
             seq_length=seq_length,
         )
+        for counter, counter_label in counters.items():
+            if counter not in filtered_data.columns or filtered_data[counter].isna().all():
+                continue
+            plot_line(
+                filtered_data.dropna(subset=[counter]),
+                x=params["x"],
+                y=counter,
+                hue=params["hue"],
+                title=f"{params['x_label']} vs {counter_label}",
+                x_label=params["x_label"],
+                y_label=counter_label,
+                output_file=os.path.join(output_dir, f"{experiment.replace(' ', '_')}_{counter.replace(' ', '_')}.png"),
+                sample_count=sample_count,
+                seq_length=seq_length,
+                log_scale=counter == "Instructions Per Cell",
+            )
     elif params["type"] == "heatmap_grid":
         plot_heatmap_grid(
             filtered_data,
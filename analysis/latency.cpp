@@ -0,0 +1,166 @@
+#include "include/wfa.hpp"
+#include "include/wfa_simd.hpp"
+#include "include/naive.hpp"
+#include "include/pair_dataset.hpp"
+#include "include/data_gen.hpp"
+#include "bindings/cpp/WFAligner.hpp"
+#include "fmt/format.h"
+#include "fmt/os.h"
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Times every alignment of a fixed dataset on its own, after a warm-up pass, and reports throughput along with the latency percentiles,
+// which the whole-loop totals of wfa2_comparison and experiment can not show
+
+using bench_clock = std::chrono::steady_clock;
+
+// Keeps the compiler from dropping a computation whose result is otherwise unused
+template <typename T>
+inline void do_not_optimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile T sink;
+    sink = value;
+#endif
+}
+
+struct latency_result_t {
+    std::string algorithm;
+    double pairs_per_second;
+    double gcups;
+    double mean;
+    uint64_t p50;
+    uint64_t p99;
+    uint64_t p999;
+    uint64_t max;
+    // Alignments per power of two nanoseconds, bucket i counting latencies in [2^i, 2^(i+1))
+    std::vector<uint64_t> histogram;
+};
+
+// The latency below which the given fraction of the sorted samples lie
+static uint64_t percentile(const std::vector<uint64_t>& sorted, double fraction) {
+    size_t index = static_cast<size_t>(fraction * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[index];
+}
+
+// Aligns every pair once untimed, to warm the caches, the arena and the branch predictors, then repetitions times with each alignment timed.
+// GCUPS counts the cells of the full dynamic programming matrix, |a| * |b| per pair, so engines that skip most of them score above the naive one
+template <typename align_t>
+static latency_result_t measure(const std::string& algorithm, const wfa::pair_dataset_t& dataset, int repetitions, align_t align) {
+    for (size_t i = 0; i < dataset.size(); ++i) {
+        auto [a, b] = dataset[i];
+        do_not_optimize(align(a, b));
+    }
+
+    std::vector<uint64_t> latencies;
+    latencies.reserve(dataset.size() * repetitions);
+    uint64_t cells = 0;
+    bench_clock::duration total{};
+    for (int repetition = 0; repetition < repetitions; ++repetition) {
+        for (size_t i = 0; i < dataset.size(); ++i) {
+            auto [a, b] = dataset[i];
+            auto start = bench_clock::now();
+            int32_t score = align(a, b);
+            do_not_optimize(score);
+            auto end = bench_clock::now();
+            total += end - start;
+            latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+            cells += static_cast<uint64_t>(a.size()) * b.size();
+        }
+    }
+
+    latency_result_t result;
+    result.algorithm = algorithm;
+    double seconds = std::chrono::duration<double>(total).count();
+    result.pairs_per_second = latencies.size() / seconds;
+    result.gcups = cells / seconds / 1e9;
+    result.mean = std::chrono::duration<double, std::nano>(total).count() / latencies.size();
+    for (uint64_t latency : latencies) {
+        size_t bucket = std::bit_width(std::max<uint64_t>(latency, 1)) - 1;
+        if (bucket >= result.histogram.size()) {
+            result.histogram.resize(bucket + 1);
+        }
+        ++result.histogram[bucket];
+    }
+    std::sort(latencies.begin(), latencies.end());
+    result.p50 = percentile(latencies, 0.5);
+    result.p99 = percentile(latencies, 0.99);
+    result.p999 = percentile(latencies, 0.999);
+    result.max = latencies.back();
+    return result;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 7 && argc != 8) {
+        fmt::println("Usage: {} <error_rate> <sequence_length> <num_sequences> <x> <o> <e> [repetitions]", argv[0]);
+        return 1;
+    }
+
+    double error_rate = std::stod(argv[1]);
+    int sequence_length = std::stoi(argv[2]);
+    int num_sequences = std::stoi(argv[3]);
+    int x = std::stoi(argv[4]);
+    int o = std::stoi(argv[5]);
+    int e = std::stoi(argv[6]);
+    int repetitions = argc == 8 ? std::max(std::stoi(argv[7]), 1) : 5;
+
+    // The same reads_*.wfad datasets experiment keeps, so a run can be repeated on identical inputs
+    std::string path = "reads_" + std::to_string(sequence_length) + "_" + std::to_string(num_sequences) + "_" + std::to_string(error_rate) + ".wfad";
+    if (!wfa::pair_dataset_t(path).is_open()) {
+        wfa::write_dataset(path, wfa::generate_pairs(wfa::error_model(sequence_length, error_rate), num_sequences));
+    }
+    wfa::pair_dataset_t dataset(path);
+    if (!dataset.is_open() || dataset.size() == 0) {
+        fmt::println("Failed to open dataset: {}", path);
+        return 1;
+    }
+
+    std::vector<latency_result_t> results;
+    wfa::wavefront_arena_t arena;
+    // Naive needs a full DP matrix, so it is skipped for long reads
+    if (sequence_length <= 5000) {
+        results.push_back(measure("Naive", dataset, repetitions, [&](std::string_view a, std::string_view b) {
+            return wfa::naive(a, b, x, o, e);
+        }));
+    }
+    results.push_back(measure("Wavefront", dataset, repetitions, [&](std::string_view a, std::string_view b) {
+        return wfa::wavefront(a, b, x, o, e, arena);
+    }));
+    results.push_back(measure("Wavefront SIMD", dataset, repetitions, [&](std::string_view a, std::string_view b) {
+        return wfa::wavefront_simd(a, b, x, o, e, arena);
+    }));
+    wfa::WFAlignerGapAffine aligner(x, o, e, wfa::WFAligner::Score, wfa::WFAligner::MemoryHigh);
+    results.push_back(measure("WFA2-lib", dataset, repetitions, [&](std::string_view a, std::string_view b) {
+        aligner.alignEnd2End(a.data(), static_cast<int>(a.size()), b.data(), static_cast<int>(b.size()));
+        return aligner.getAlignmentScore();
+    }));
+
+    fmt::println("{} pairs of length {} at error rate {}, {} repetitions, {} extend kernels", dataset.size(), sequence_length, error_rate, repetitions, wfa::simd_level_name(wfa::simd_level()));
+    fmt::println("{:<16}{:>14}{:>10}{:>12}{:>12}{:>12}{:>12}{:>12}", "Algorithm", "Pairs/s", "GCUPS", "Mean (ns)", "p50 (ns)", "p99 (ns)", "p999 (ns)", "Max (ns)");
+    for (const auto& result : results) {
+        fmt::println("{:<16}{:>14.0f}{:>10.3f}{:>12.0f}{:>12}{:>12}{:>12}{:>12}", result.algorithm, result.pairs_per_second, result.gcups, result.mean, result.p50, result.p99, result.p999, result.max);
+    }
+
+    // One row per algorithm, and one per histogram bucket, for graph.py or a spreadsheet
+    auto csv = fmt::output_file("latency_results.csv");
+    csv.print("Algorithm,Sample Count,Sequence Length,Error Rate,Mismatch Penalty,Gap Opening Cost,Gap Extension Cost,Repetitions,Pairs Per Second,GCUPS,Mean Latency,P50 Latency,P99 Latency,P999 Latency,Max Latency\n");
+    for (const auto& result : results) {
+        csv.print("{},{},{},{},{},{},{},{},{},{},{},{},{},{},{}\n", result.algorithm, dataset.size(), sequence_length, error_rate, x, o, e, repetitions, result.pairs_per_second, result.gcups, result.mean, result.p50, result.p99, result.p999, result.max);
+    }
+    auto histogram = fmt::output_file("latency_histogram.csv");
+    histogram.print("Algorithm,Bucket Start (ns),Count\n");
+    for (const auto& result : results) {
+        for (size_t bucket = 0; bucket < result.histogram.size(); ++bucket) {
+            if (result.histogram[bucket] != 0) {
+                histogram.print("{},{},{}\n", result.algorithm, uint64_t(1) << bucket, result.histogram[bucket]);
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "fmt/format.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Hardware counters read through Linux perf_event_open, for the analysis tools to wrap around an algorithm run.
+// Elsewhere, or where the kernel refuses the counters (perf_event_paranoid above 2, containers without the syscall, virtual machines without a PMU), every sample is invalid and the tools leave the columns empty
+
+struct perf_sample_t {
+    bool valid = false;
+    uint64_t cycles = 0;
+    uint64_t instructions = 0;
+    uint64_t cache_references = 0;
+    uint64_t cache_misses = 0;
+    uint64_t branches = 0;
+    uint64_t branch_misses = 0;
+
+    double ipc() const { return cycles == 0 ? 0.0 : static_cast<double>(instructions) / cycles; }
+    double cache_miss_rate() const { return cache_references == 0 ? 0.0 : static_cast<double>(cache_misses) / cache_references; }
+    double branch_miss_rate() const { return branches == 0 ? 0.0 : static_cast<double>(branch_misses) / branches; }
+};
+
+// One counter per event, each counting user space only so the default perf_event_paranoid setting allows it.
+// Counters are inherited by threads started while they run, which covers the thread pools of the batch and parallel engines
+class perf_counters_t {
+public:
+    perf_counters_t() {
+#ifdef __linux__
+        constexpr std::array<uint64_t, 6> events = {
+            PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_CACHE_REFERENCES, PERF_COUNT_HW_CACHE_MISSES,
+            PERF_COUNT_HW_BRANCH_INSTRUCTIONS, PERF_COUNT_HW_BRANCH_MISSES,
+        };
+        for (size_t i = 0; i < events.size(); ++i) {
+            perf_event_attr attr{};
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = events[i];
+            attr.disabled = 1;
+            attr.inherit = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            descriptors[i] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+            if (descriptors[i] == -1) {
+                close_all();
+                return;
+            }
+        }
+#endif
+    }
+
+    ~perf_counters_t() {
+        close_all();
+    }
+
+    perf_counters_t(const perf_counters_t&) = delete;
+    perf_counters_t& operator=(const perf_counters_t&) = delete;
+
+    // Whether the kernel handed out every counter
+    bool available() const {
+        return descriptors[0] != -1;
+    }
+
+    void start() {
+#ifdef __linux__
+        for (int descriptor : descriptors) {
+            if (descriptor != -1) {
+                ioctl(descriptor, PERF_EVENT_IOC_RESET, 0);
+                ioctl(descriptor, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+#endif
+    }
+
+    // The counts since start. Counters the PMU had to multiplex are scaled up by the share of the time they ran
+    perf_sample_t stop() {
+        perf_sample_t sample;
+#ifdef __linux__
+        if (!available()) {
+            return sample;
+        }
+        std::array<uint64_t, 6> counts{};
+        for (size_t i = 0; i < descriptors.size(); ++i) {
+            ioctl(descriptors[i], PERF_EVENT_IOC_DISABLE, 0);
+            uint64_t values[3] = {};
+            if (read(descriptors[i], values, sizeof(values)) != sizeof(values)) {
+                return sample;
+            }
+            counts[i] = values[2] == 0 ? 0 : static_cast<uint64_t>(static_cast<double>(values[0]) * values[1] / values[2]);
+        }
+        sample.valid = true;
+        sample.cycles = counts[0];
+        sample.instructions = counts[1];
+        sample.cache_references = counts[2];
+        sample.cache_misses = counts[3];
+        sample.branches = counts[4];
+        sample.branch_misses = counts[5];
+#endif
+        return sample;
+    }
+
+private:
+    std::array<int, 6> descriptors = { -1, -1, -1, -1, -1, -1 };
+
+    void close_all() {
+#ifdef __linux__
+        for (int& descriptor : descriptors) {
+            if (descriptor != -1) {
+                close(descriptor);
+                descriptor = -1;
+            }
+        }
+#endif
+    }
+};
+
+// The header of the counter columns
+inline constexpr const char* perf_csv_header = "Cycles,Instructions,IPC,Instructions Per Cell,Cache Misses,Cache Miss Rate,Branch Misses,Branch Miss Rate";
+
+// The counters as CSV columns, matching perf_csv_header, and empty where the sample is invalid. cells is the number of DP cells the run covered, sum of |a| * |b|
+inline std::vector<std::string> perf_csv_columns(const perf_sample_t& sample, uint64_t cells) {
+    if (!sample.valid) {
+        return std::vector<std::string>(8);
+    }
+    return {
+        std::to_string(sample.cycles),
+        std::to_string(sample.instructions),
+        fmt::format("{:.4f}", sample.ipc()),
+        fmt::format("{:.6f}", cells == 0 ? 0.0 : static_cast<double>(sample.instructions) / cells),
+        std::to_string(sample.cache_misses),
+        fmt::format("{:.6f}", sample.cache_miss_rate()),
+        std::to_string(sample.branch_misses),
+        fmt::format("{:.6f}", sample.branch_miss_rate()),
+    };
+}
+
+// A short summary to print after a timing, or nothing where the sample is invalid
+inline std::string perf_summary(const perf_sample_t& sample, uint64_t cells) {
+    if (!sample.valid) {
+        return "";
+    }
+    return fmt::format(" (IPC {:.2f}, {:.3f} instructions/cell, {:.2f}% cache misses, {:.2f}% branch misses)",
+        sample.ipc(), cells == 0 ? 0.0 : static_cast<double>(sample.instructions) / cells, 100 * sample.cache_miss_rate(), 100 * sample.branch_miss_rate());
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "fmt/format.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <string_view>
+#include <thread>
+
+namespace wfa {
+	//One pairwise alignment to format. a is the reference (target) and b the read (query), matching the cigar, where I consumes b and D consumes a.
+	//cigar holds one character per operation as written by wfa::backtrace, and may be empty for score-only alignments. b_sequence is only used for the SEQ field of SAM
+	struct alignment_record_t {
+		std::string_view a_name;
+		std::string_view b_name;
+		int32_t a_length;
+		int32_t b_length;
+		int32_t score;
+		std::string_view cigar;
+		std::string_view b_sequence;
+	};
+
+	//Appends the run length encoded form of a one character per operation cigar, writing matches as = so they are not confused with mismatches, e.g. MMMXMM becomes 3=1X2=
+	void append_cigar(fmt::memory_buffer& out, std::string_view cigar);
+
+	//Appends one PAF line. The alignment is end to end, so it covers all of both sequences. Tags: NM (edit distance) and cg (the cigar) when there is a cigar, and AS (the score)
+	void format_paf(fmt::memory_buffer& out, const alignment_record_t& record);
+
+	//Appends the header of a minimal SAM file. Every pair has its own reference, so there are no @SQ lines
+	void format_sam_header(fmt::memory_buffer& out);
+
+	//Appends one SAM line with the read aligned from the first base of its reference, with AS and, when there is a cigar, NM tags
+	void format_sam(fmt::memory_buffer& out, const alignment_record_t& record);
+
+	//Writes blocks of formatted output from a thread of its own, in order of their indices whatever order they are submitted in, so workers formatting into their own buffers never wait on I/O.
+	//Consecutive blocks that are ready together are written in one go
+	struct ordered_writer_t {
+		//Writes to file, letting up to max_pending blocks queue up before submit waits
+		explicit ordered_writer_t(std::FILE* file, size_t max_pending = 64);
+		~ordered_writer_t();
+
+		//Hands block <index> over to the writer. Blocks are numbered from 0 without gaps. Waits while the queue is full, unless this is the block the writer needs next,
+		//so threads have to take indices in increasing order and submit each one before taking another, or a thread waiting with a later block could hold back an earlier one
+		void submit(size_t index, fmt::memory_buffer&& block);
+		//Writes every block left and stops the writer thread. Also called by the destructor
+		void finish();
+
+		ordered_writer_t(const ordered_writer_t& rhs) = delete;
+		ordered_writer_t& operator=(const ordered_writer_t& rhs) = delete;
+
+	private:
+		std::FILE* file;
+		size_t max_pending;
+		std::mutex mutex;
+		std::condition_variable ready;
+		std::condition_variable space;
+		std::map<size_t, fmt::memory_buffer> pending;
+		size_t next = 0;
+		bool finished = false;
+		//Started last, once everything it reads is constructed
+		std::jthread thread;
+
+		void run();
+	};
+}
@@ -1,7 +1,10 @@
 #pragma once
 
+#include <cstdint>
 #include <vector>
 #include <string>
+#include <string_view>
+#include <utility>
 
 
 namespace wfa {
@@ -11,4 +14,50 @@ namespace wfa {
 	//generates pairs sequences of nucleobases of provided length and count, where the second element in the pair the first sequence modified by the provided error rate.
 	std::vector<std::pair<std::string, std::string>> modify_sequences(int32_t length, int32_t count, double error_rate);
 
-}
\ No newline at end of file
+	//How the lengths of the first sequences are drawn: always length, uniformly from [length - spread, length + spread], or normally with mean length and standard deviation spread. Lengths are at least 1
+	enum class length_model_t {
+		fixed,
+		uniform,
+		normal,
+	};
+
+	//The read model of wfa::generate_pairs. The second sequence of a pair is the first one copied with errors, all rates being per base of the first sequence
+	struct read_model_t {
+		uint64_t seed = 1;
+		int32_t length = 1000;
+		length_model_t length_model = length_model_t::fixed;
+		int32_t length_spread = 0;
+
+		//A substituted base is always a different one
+		double mismatch_rate = 0.0;
+		double insertion_rate = 0.0;
+		double deletion_rate = 0.0;
+
+		//Insertions and deletions inside a run of at least homopolymer_length equal bases are homopolymer_factor times as likely, and an insertion there repeats the run's base, like the indels of nanopore and PacBio reads
+		int32_t homopolymer_length = 3;
+		double homopolymer_factor = 1.0;
+
+		//Long insertions or deletions, equally likely, of a geometrically distributed length with mean long_indel_length
+		double long_indel_rate = 0.0;
+		int32_t long_indel_length = 50;
+	};
+
+	//Generated pairs, every sequence back to back in one buffer. Sequence i spans bases[offsets[i], offsets[i + 1]), the pair p being sequences 2p and 2p + 1, as in a wfa::pair_dataset_t
+	struct generated_pairs_t {
+		std::string bases;
+		std::vector<uint64_t> offsets{ 0 };
+
+		size_t size() const { return (offsets.size() - 1) / 2; }
+		std::pair<std::string_view, std::string_view> operator[](size_t i) const;
+		//Copies out every pair, for the functions that take owned strings
+		std::vector<std::pair<std::string, std::string>> load() const;
+	};
+
+	//A read model of fixed length whose errors are split evenly between mismatches, insertions and deletions, the one the analysis tools generate their datasets with
+	read_model_t error_model(int32_t length, double error_rate, uint64_t seed = 1);
+
+	//Generates count pairs with the given read model on threads threads, 0 for one per hardware thread. Every pair draws from a generator seeded by the model's seed and its index,
+	//so the same seed gives the same pairs on any number of threads
+	generated_pairs_t generate_pairs(const read_model_t& model, size_t count, size_t threads = 0);
+
+}
@@ -19,6 +19,72 @@ namespace wfa {
 	 */
 	int32_t naive(std::string_view a, std::string_view b, int32_t x, int32_t o, int32_t e);
 
+	/**
+	 * @brief Calculates the gap-linear alignment cost between two sequences using a naive dynamic programming approach.
+	 *
+	 * The reference for the gap-linear and edit-distance wavefront algorithms. Every inserted or deleted
+	 * base costs e, with no cost for opening a gap, so a single matrix is enough. The edit distance is
+	 * `naive_linear(a, b, 1, 1)`.
+	 *
+	 * @param a The first sequence as a `std::string_view`.
+	 * @param b The second sequence as a `std::string_view`.
+	 * @param x The penalty cost for mismatches between sequences.
+	 * @param e The cost for each base of a gap in the alignment.
+	 * @return int The alignment cost between the two sequences.
+	 */
+	int32_t naive_linear(std::string_view a, std::string_view b, int32_t x, int32_t e);
+
+	/**
+	 * @brief Calculates the two-piece gap-affine alignment cost between two sequences using a naive dynamic programming approach.
+	 *
+	 * The reference for the two-piece wavefront algorithms. Keeps an insertion and a deletion matrix for each
+	 * gap model, so a gap of length l costs min(o1 + l * e1, o2 + l * e2).
+	 *
+	 * @param a The first sequence as a `std::string_view`.
+	 * @param b The second sequence as a `std::string_view`.
+	 * @param x The penalty cost for mismatches between sequences.
+	 * @param o1 The cost for opening a gap with the first model.
+	 * @param e1 The cost for extending a gap with the first model.
+	 * @param o2 The cost for opening a gap with the second model.
+	 * @param e2 The cost for extending a gap with the second model.
+	 * @return int The alignment cost between the two sequences.
+	 */
+	int32_t naive_affine2p(std::string_view a, std::string_view b, int32_t x, int32_t o1, int32_t e1, int32_t o2, int32_t e2);
+
+	/**
+	 * @brief Calculates the ends-free gap-affine alignment cost between two sequences using a naive dynamic programming approach.
+	 *
+	 * The reference for the ends-free wavefront algorithms. The first a_begin cells of the first column and
+	 * b_begin cells of the first row start at no cost, and the best score is taken from the last a_end + 1
+	 * cells of the last column and the last b_end + 1 cells of the last row.
+	 *
+	 * @param a The first sequence as a `std::string_view`.
+	 * @param b The second sequence as a `std::string_view`.
+	 * @param x The penalty cost for mismatches between sequences.
+	 * @param o The cost for opening a gap in the alignment.
+	 * @param e The cost for extending a gap in the alignment.
+	 * @param a_begin, a_end, b_begin, b_end The number of bases at each end of a and b that may be skipped for free.
+	 * @return int The alignment cost between the two sequences.
+	 */
+	int32_t naive_ends_free(std::string_view a, std::string_view b, int32_t x, int32_t o, int32_t e, int32_t a_begin, int32_t a_end, int32_t b_begin, int32_t b_end);
+
+	/**
+	 * @brief Calculates the best extension score of two sequences using a naive dynamic programming approach.
+	 *
+	 * The reference for the extension wavefront algorithms with a threshold too large to drop anything. Fills
+	 * the gap-affine matrix from the first bases of a and b, and returns the best match * (i + j) - penalty
+	 * over every cell (i, j).
+	 *
+	 * @param a The first sequence as a `std::string_view`.
+	 * @param b The second sequence as a `std::string_view`.
+	 * @param x The penalty cost for mismatches between sequences.
+	 * @param o The cost for opening a gap in the alignment.
+	 * @param e The cost for extending a gap in the alignment.
+	 * @param match The reward for each base of a and b the alignment covers.
+	 * @return int The best extension score, at least 0 for the empty extension.
+	 */
+	int32_t naive_extension(std::string_view a, std::string_view b, int32_t x, int32_t o, int32_t e, int32_t match);
+
 	/**
 	 * @brief Computes the alignment cost between two sequences using a wavefront alignment approach.
 	 *
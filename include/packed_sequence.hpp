@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace wfa {
+	//A nucleotide sequence packed 2 bits per base, so one 64-bit compare covers 32 bases.
+	//A, C, G and T are packed as 0, 1, 2 and 3. Anything else (N, ambiguity codes, lowercase) is packed as A and kept in a side list with its original character, so comparisons give the same answer as comparing the characters
+	struct packed_sequence_t {
+		//The first base of each word is in its highest bits. One word of padding at the end lets a window of 32 bases start anywhere in the sequence
+		std::vector<uint64_t> words;
+		//Sorted positions of the bases that are not A, C, G or T
+		std::vector<int32_t> ambiguous;
+		//The original characters at those positions
+		std::string ambiguous_bases;
+		int32_t length = 0;
+
+		packed_sequence_t() = default;
+		explicit packed_sequence_t(std::string_view sequence);
+
+		//Repacks the sequence in place, reusing the buffers
+		void assign(std::string_view sequence);
+
+		int32_t size() const { return length; }
+		//The 32 bases starting at position i, first base in the highest bits. Bases past the end read as A
+		uint64_t window(int32_t i) const;
+		//The original character at position i
+		char at(int32_t i) const;
+	};
+
+	//The number of bases a[v..] and b[h..] share before their first mismatch or the end of either sequence. XORs 32 bases at a time, and finds the first mismatch with a count of leading zeros
+	int32_t match_length(const packed_sequence_t& a, int32_t v, const packed_sequence_t& b, int32_t h);
+}
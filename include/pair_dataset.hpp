@@ -0,0 +1,58 @@
+#pragma once
+
+#include "sequence_reader.hpp"
+#include "data_gen.hpp"
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace wfa {
+	//The start of a pair dataset file. It is followed by 2 * pairs + 1 uint64_t offsets, sequence i spanning bases [offsets[i], offsets[i + 1]) with the two sequences of pair p at 2p and 2p + 1,
+	//and then the blob of every sequence back to back, one byte or, when packed, 2 bits per base. Everything is stored in the byte order of the machine that wrote it
+	struct dataset_header_t {
+		char magic[8];
+		uint32_t version;
+		uint32_t packed;
+		uint64_t pairs;
+		uint64_t blob_size;
+	};
+
+	//Writes pairs to a dataset file at path. Packing stores 4 bases per byte, for sequences of only A, C, G and T.
+	//Returns false if the file could not be written, or packed was asked for and a sequence has another character
+	bool write_dataset(const std::string& path, std::span<const std::pair<std::string, std::string>> pairs, bool packed = false);
+
+	//Writes every pair a reader gives to a dataset file at path, see above
+	bool write_dataset(const std::string& path, pair_reader_t& reader, bool packed = false);
+
+	//Writes generated pairs to a dataset file at path, see above
+	bool write_dataset(const std::string& path, const generated_pairs_t& pairs, bool packed = false);
+
+	//A memory-mapped pair dataset. Opening checks the header and the index but never touches the sequences, which are only paged in as pairs are read
+	struct pair_dataset_t {
+		explicit pair_dataset_t(const std::string& path);
+
+		//Whether the file was mapped and holds a dataset this version can read
+		bool is_open() const { return header != nullptr; }
+		size_t size() const { return static_cast<size_t>(header->pairs); }
+		bool packed() const { return header->packed != 0; }
+
+		//Pair i as views into the mapping, only for datasets that are not packed
+		std::pair<std::string_view, std::string_view> operator[](size_t i) const;
+		//Decodes pair i into a and b, reusing their buffers. Works for either kind of dataset
+		void unpack(size_t i, std::string& a, std::string& b) const;
+		//Copies out every pair, for the engines that take a batch of owned strings
+		std::vector<std::pair<std::string, std::string>> load() const;
+
+	private:
+		mapped_file_t file;
+		const dataset_header_t* header = nullptr;
+		const uint64_t* offsets = nullptr;
+		const char* blob = nullptr;
+
+		void decode(size_t sequence, std::string& out) const;
+	};
+}
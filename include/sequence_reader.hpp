@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace wfa {
+	//A read-only memory mapping of a whole file. Records parsed from it are views into the mapping, so it has to outlive them
+	struct mapped_file_t {
+		const char* data = nullptr;
+		size_t size = 0;
+
+		//Maps the file at path, check is_open for whether that worked. An empty file opens with no mapping
+		explicit mapped_file_t(const std::string& path);
+		~mapped_file_t();
+
+		bool is_open() const { return open; }
+		std::string_view contents() const { return std::string_view(data, size); }
+
+		//Move only!
+		mapped_file_t(mapped_file_t&& rhs) noexcept;
+		mapped_file_t& operator=(mapped_file_t&& rhs) noexcept;
+		mapped_file_t(const mapped_file_t& rhs) = delete;
+		mapped_file_t& operator=(const mapped_file_t& rhs) = delete;
+
+	private:
+		bool open = false;
+#ifdef _WIN32
+		//Without mmap the file is read into memory once
+		std::string buffer;
+#endif
+	};
+
+	//A FASTA or FASTQ record. The name is the header up to the first whitespace
+	struct sequence_record_t {
+		std::string_view name;
+		std::string_view sequence;
+	};
+
+	//Parses FASTA and FASTQ records one at a time out of a buffer, telling them apart by the first character of each record, so a file may even mix the two.
+	//A sequence on a single line, which includes every FASTQ record, is a view straight into the buffer. FASTA sequences wrapped over several lines are joined into a buffer owned by the reader, valid until the next call
+	struct sequence_reader_t {
+		std::string_view contents;
+		size_t position = 0;
+		//Set when next stopped at a record it could not parse rather than at the end of the input
+		bool failed = false;
+		std::string joined;
+
+		explicit sequence_reader_t(std::string_view contents) : contents(contents) {}
+
+		//Reads the next record, returns false at the end of the input or on a malformed record
+		bool next(sequence_record_t& record);
+	};
+
+	//Reads pairs of records, the nth record of one input against the nth of the other, or consecutive records of a single interleaved input
+	struct pair_reader_t {
+		sequence_reader_t a;
+		sequence_reader_t b;
+		bool interleaved;
+		//Holds a wrapped first sequence of an interleaved pair while the second one is read
+		std::string joined;
+
+		pair_reader_t(std::string_view a_contents, std::string_view b_contents) : a(a_contents), b(b_contents), interleaved(false) {}
+		explicit pair_reader_t(std::string_view interleaved_contents) : a(interleaved_contents), b(std::string_view()), interleaved(true) {}
+
+		//Reads the next pair, returns false once either input runs out or fails to parse
+		bool next(sequence_record_t& first, sequence_record_t& second);
+		bool failed() const { return a.failed or b.failed; }
+	};
+}
@@ -7,6 +7,9 @@
 #include <unordered_set>
 #include "ankerl/unordered_dense.h"
 #include <span>
+#include <memory>
+#include <limits>
+#include "packed_sequence.hpp"
 
 namespace wfa {
 	//using wavefront_t = std::vector<std::array<std::vector<int32_t>, 3>>;
@@ -14,18 +17,75 @@ namespace wfa {
 	int32_t constexpr del = 1;
 	int32_t constexpr match = 2;
 
-	//A memory arena for use in the wave front types
-	//Reuse between runs of the algorithm
+	//A memory arena for use in the wave front types. Memory comes from fixed size blocks that never move, so views into the arena stay valid for a whole alignment
+	//Reuse between runs of the algorithm, the blocks are kept and handed out again
 	struct wavefront_arena_t {
-		std::vector<int32_t> data;
+		//The number of int32_t in a block. Larger allocations get a block of their own size
+		static constexpr size_t block_size = 1 << 16;
+
+		//A block is allocated without initialization, wavefronts overwrite every value they read
+		struct block_t {
+			std::unique_ptr<int32_t[]> data;
+			size_t size;
+		};
+		std::vector<block_t> blocks;
+		//The block allocations currently come from, and how much of it is used
+		size_t current_block = 0;
 		size_t current_index = 0;
 
 		//Allocates <size> number of int32_t, returns a pointer to the beginning of the set
 		int32_t* alloc(size_t size);
+		//Hands the last <size> int32_t of the newest allocation back to the arena
+		void release(size_t size);
+		//Makes every block available again for the next run
+		void reset();
+		//The number of int32_t in all the blocks, which is the most the arena has needed at once
+		size_t capacity() const;
+	};
+
+	//Returned instead of a score by the bounded overloads when the alignment would cost more than max_score
+	int32_t constexpr score_exceeded = std::numeric_limits<int32_t>::min();
+
+	//Settings for the adaptive wavefront reduction heuristic. Once a wavefront spans at least min_wavefront_length diagonals, the diagonals at its ends whose distance to the end of the alignment trails the closest one by more than max_distance_threshold are dropped.
+	//This keeps wavefronts narrow at high error rates, but the optimal alignment may be dropped with them, so scores can come out worse than optimal
+	struct reduction_t {
+		int32_t min_wavefront_length = 10;
+		int32_t max_distance_threshold = 50;
+	};
+
+	//Gap-affine penalties passed at runtime
+	struct penalties_t {
+		int32_t x;
+		int32_t o;
+		int32_t e;
+	};
 
+	//Gap-affine penalties fixed at compile time. The kernels are templates that read the penalties as p.x, p.o and p.e, so with these the compiler folds them into the code
+	template <int32_t X, int32_t O, int32_t E>
+	struct fixed_penalties_t {
+		static constexpr int32_t x = X;
+		static constexpr int32_t o = O;
+		static constexpr int32_t e = E;
 	};
 
+	//Calls function with the penalties as a fixed_penalties_t if they are one of the precompiled sets, and as a penalties_t otherwise
+	template <typename function_t>
+	auto dispatch_penalties(int32_t x, int32_t o, int32_t e, function_t&& function) {
+		if (x == 4 and o == 6 and e == 2) {
+			return function(fixed_penalties_t<4, 6, 2>{});
+		}
+		if (x == 2 and o == 3 and e == 1) {
+			return function(fixed_penalties_t<2, 3, 1>{});
+		}
+		return function(penalties_t{ x, o, e });
+	}
+
+	//The guard cells on each side of every wavefront column, holding -1 like a lookup outside [low, high]. Vector loads that run up to this many diagonals past a column's ends need no bounds checks,
+	//so it covers the widest register any CPU the build runs on may pick, 16 int32_t for AVX-512
+	int32_t constexpr wavefront_guard = 16;
+
 	//An individual wavefront for the WFA algorithm
+	//Its columns are laid out back to back with wavefront_guard guard cells before the first one and after each one, the cells after a column doubling as the ones before the next
 	struct wavefront_entry_t {
 		//The range of diagonals covered
 		int32_t low;
@@ -41,8 +101,14 @@ namespace wfa {
 		int32_t& no_bound(int32_t column, int32_t row);
 		//returns the pointer to the start of the given column
 		int32_t* start_ptr(int32_t column);
+		//Sets every guard cell to -1
+		void fill_guards();
+
+		//The number of int32_t a wavefront of <number_per_col> diagonals and <columns> columns takes, guard cells included
+		static size_t allocation(int32_t number_per_col, int32_t columns);
 
-		wavefront_entry_t(int32_t low, int32_t high, wavefront_arena_t& arena);
+		//Allocates <columns> columns from the arena, the three offset columns plus any a traceback mode stores alongside them
+		wavefront_entry_t(int32_t low, int32_t high, wavefront_arena_t& arena, int32_t columns = 3);
 		wavefront_entry_t(); //Default constructor for false states
 
 		wavefront_entry_t(wavefront_entry_t&& rhs);
@@ -59,8 +125,14 @@ namespace wfa {
 		//A vector of wavefronts
 		std::vector<wavefront_entry_t> views;
 		//A vector mapping scores as indexs to indexs into views. -1 sentinal value for no wavefront with that score
+		//In a ring it instead holds the score each slot was last used for
 		std::vector<int32_t> mapping;
 
+		//The index into views of the wavefront with the given score, or -1 if there is none
+		int32_t index(int32_t score);
+		//The wavefront inserted last
+		wavefront_entry_t& newest();
+
 		int32_t lookup(int32_t score, int32_t column, int32_t k);
 		int32_t wave_size_low(int32_t score);
 		int32_t wave_size_high(int32_t score);
@@ -68,21 +140,77 @@ namespace wfa {
 		//checks if a score is valid and exists in the views
 		bool valid_score(int32_t score);
 		
-		//inserts a new wavefront and handles reallocation and updating views
+		//inserts a new wavefront
 		wavefront_entry_t& insert(int32_t low, int32_t high);
 		//inserts a dummy wavefront with no underlying allocation
 		void insert();
 
+		//Narrows the newest wavefront to the diagonals [low, high], handing the rest of its allocation back to the arena
+		void shrink(int32_t low, int32_t high);
+
+		//Keeps only the wavefronts of the last <window> scores, moving them to the front of the arena so it stops growing. Older scores become invalid
+		void compact(int32_t window);
+
+		//Switches an empty wavefront_t to a ring that only holds the wavefronts of the last <window> scores, for score-only runs where next never reads further back.
+		//Every slot of the ring reuses one stretch of the arena, so memory is bounded by the width of the wavefronts rather than the score
+		void ring(int32_t window);
+
+		//The number of columns in every wavefront
+		int32_t columns;
+
+		//The number of slots in the ring, a power of two, or 0 if every wavefront is kept
+		int32_t slots = 0;
+		//The number of scores inserted into the ring so far
+		int32_t scores = 0;
+		//Where the slots start in the arena, and how many int32_t each one holds
+		int32_t* ring_data = nullptr;
+		size_t slot_size = 0;
+
 		void print();
 
-		wavefront_t(wavefront_arena_t& arena) : arena(arena) {}
+		wavefront_t(wavefront_arena_t& arena, int32_t columns = 3) : arena(arena), columns(columns) {}
 	};
 
+	//The number of characters a[v..] and b[h..] share before their first mismatch or the end of either sequence. XORs 8 bytes at a time and finds the first mismatch with a count of trailing zeros
+	int32_t match_length(std::string_view a, int32_t v, std::string_view b, int32_t h);
+
+	//The word kernel behind match_length, for callers that already know the first i of limit bytes match. The tail rereads the last 8 bytes, so it never falls back to single bytes unless the run is shorter than a word
+	int32_t match_length_words(const char* a, const char* b, int32_t i, int32_t limit);
+
+	//Extends every diagonal of the newest wavefront along its run of matches, a word at a time
 	bool extend(wavefront_t& wavefront, std::string_view a, std::string_view b);
 
 	void next(wavefront_t& wavefront, int32_t s, int32_t x, int32_t o, int32_t e);
 
+	//Extends straight from packed sequences, comparing 32 bases per step
+	bool extend(wavefront_t& wavefront, const packed_sequence_t& a, const packed_sequence_t& b);
+
+	//Applies the adaptive wavefront reduction heuristic to the newest, extended wavefront of an alignment of sequences with lengths n and m
+	void reduce(wavefront_t& wavefront, int32_t n, int32_t m, const reduction_t& reduction);
+
+
+	//Walks back through the stored wavefronts of a finished alignment with the given score, writing the operations into cigar.
+	//The cigar holds one character per operation: M (match), X (mismatch), I (insertion, consumes b) and D (deletion, consumes a).
+	//The buffer is cleared, not reallocated, so reusing it between calls avoids an allocation per pair.
+	//begin and end give the column the alignment started and finished in, which is only something other than match for the pieces of a bidirectional alignment
+	void backtrace(wavefront_t& wavefront, std::string_view a, std::string_view b, int32_t score, int32_t x, int32_t o, int32_t e, std::string& cigar, int32_t begin = match, int32_t end = match);
 
 	//The wavefront alignment algorithm implementation. Aligns strings a and b with the provided substitution cost x, open cost o, and extend cost e. Uses the provided memory arena as it runs
 	int32_t wavefront(std::string_view a, std::string_view b, int32_t x, int32_t o, int32_t e, wavefront_arena_t& arena);
+
+	//The wavefront alignment algorithm with traceback. Same as above, but also writes the alignment into the caller-supplied cigar buffer
+	int32_t wavefront(std::string_view a, std::string_view b, int32_t x, int32_t o, int32_t e, wavefront_arena_t& arena, std::string& cigar);
+
+	//The wavefront alignment algorithm with adaptive wavefront reduction. Faster on noisy sequences, but may return a worse score than the optimal one
+	int32_t wavefront(std::string_view a, std::string_view b, int32_t x, int32_t o, int32_t e, wavefront_arena_t& arena, const reduction_t& reduction);
+
+	//The wavefront alignment algorithm on packed sequences, see wfa::packed_sequence_t
+	int32_t wavefront(const packed_sequence_t& a, const packed_sequence_t& b, int32_t x, int32_t o, int32_t e, wavefront_arena_t& arena);
+
+	//The wavefront alignment algorithm bounded by max_score. Stops as soon as every score up to max_score has been tried, returning wfa::score_exceeded if none of them aligned a and b
+	int32_t wavefront(std::string_view a, std::string_view b, int32_t x, int32_t o, int32_t e, wavefront_arena_t& arena, int32_t max_score);
+
+	//The wavefront alignment algorithm with the penalties fixed at compile time. Only instantiated for the sets in wfa::dispatch_penalties, which the overloads taking runtime penalties already pick automatically
+	template <int32_t X, int32_t O, int32_t E>
+	int32_t wavefront(std::string_view a, std::string_view b, wavefront_arena_t& arena);
 }
\ No newline at end of file
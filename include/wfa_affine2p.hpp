@@ -0,0 +1,33 @@
+#pragma once
+
+#include "wfa_simd.hpp"
+
+#include <string_view>
+
+namespace wfa {
+	//Columns of the second gap model. The first model keeps ins and del, and match stays in column 2 so the extend kernels work unchanged
+	int32_t constexpr ins2 = 3;
+	int32_t constexpr del2 = 4;
+	int32_t constexpr affine2p_columns = 5;
+
+	//Two-piece gap-affine penalties. A gap of length l costs min(o1 + l * e1, o2 + l * e2), usually a cheap to open, expensive to extend model for short gaps and the opposite for long ones. e1 and e2 have to be at least 1
+	struct affine2p_penalties_t {
+		int32_t x;
+		int32_t o1;
+		int32_t e1;
+		int32_t o2;
+		int32_t e2;
+	};
+
+	//The next wavefront with the two-piece recurrences, ins2 and del2 following the same rules as ins and del with the second model's costs
+	void next_affine2p(wavefront_t& wavefront, int32_t s, const affine2p_penalties_t& penalties);
+
+	//The next two-piece wavefront, a vector of diagonals at a time
+	void next_affine2p_simd(wavefront_t& wavefront, int32_t s, const affine2p_penalties_t& penalties);
+
+	//Aligns strings a and b with two-piece gap-affine penalties. Uses the provided memory arena as it runs, keeping only the wavefronts the recurrences still read
+	int32_t wavefront_affine2p(std::string_view a, std::string_view b, const affine2p_penalties_t& penalties, wavefront_arena_t& arena);
+
+	//Two-piece gap-affine alignment with manual vectorization
+	int32_t wavefront_affine2p_simd(std::string_view a, std::string_view b, const affine2p_penalties_t& penalties, wavefront_arena_t& arena);
+}
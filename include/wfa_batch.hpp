@@ -0,0 +1,33 @@
+#pragma once
+
+#include "wfa_simd.hpp"
+
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace wfa {
+	//A wavefront of a batch alignment. Each element of data holds one diagonal of one column for every lane, at data[column * (high - low + 1) + k - low]
+	struct batch_wavefront_t {
+		//The score this wavefront belongs to, -1 before its first use
+		int32_t score = -1;
+		//Whether any source wavefront existed for the score. Null scores have no diagonals
+		bool valid = false;
+		//The range of diagonals covered, which is the same for every lane as it only depends on the penalties
+		int32_t low = 0;
+		int32_t high = 0;
+		std::vector<simd_type> data;
+	};
+
+	//The memory reused between runs of the batch algorithm
+	struct batch_arena_t {
+		//Ring of the last max(x, o + e) + 1 wavefronts, indexed by score. Score-only alignment never looks further back than next does
+		std::vector<batch_wavefront_t> ring;
+	};
+
+	//Scores many pairs at once, running simd_type::size() alignments side by side with one pair per vector lane.
+	//Every lane steps through the same scores, so next runs on whole registers without gathers; lanes whose pair has finished are masked out of extend.
+	//Writes the score of pairs[i] to scores[i], which has to be at least as long as pairs
+	void wavefront_batch(std::span<const std::pair<std::string, std::string>> pairs, int32_t x, int32_t o, int32_t e, batch_arena_t& arena, std::span<int32_t> scores);
+}
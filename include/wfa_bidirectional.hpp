@@ -0,0 +1,29 @@
+#pragma once
+
+#include "wfa.hpp"
+
+#include <string>
+#include <string_view>
+
+namespace wfa {
+	//Pieces of a bidirectional alignment that score at most this are aligned directly, as their wavefronts are small enough to keep in full
+	int32_t constexpr bidirectional_fallback_score = 250;
+
+	//The memory reused between runs of the bidirectional algorithm
+	struct bidirectional_arena_t {
+		//One arena per search direction. Each only ever holds the last few wavefronts of its search
+		wavefront_arena_t forward;
+		wavefront_arena_t reverse;
+		//Both sequences back to front, so the reverse search can run the forward kernels
+		std::string a_reversed;
+		std::string b_reversed;
+		//Cigar of the piece that is currently being aligned directly
+		std::string piece;
+	};
+
+	//Scores a and b by running one wavefront search from the start and one from the end until they meet. Only the last max(x, o + e) wavefronts of each search are kept, so memory is linear in the score instead of quadratic
+	int32_t wavefront_bidirectional(std::string_view a, std::string_view b, int32_t x, int32_t o, int32_t e, bidirectional_arena_t& arena);
+
+	//The bidirectional wavefront alignment algorithm (BiWFA) with traceback. Splits the alignment where the two searches meet and recurses on both halves, aligning a half directly once its score drops to bidirectional_fallback_score. Writes the alignment into the caller-supplied cigar buffer, see wfa::backtrace
+	int32_t wavefront_bidirectional(std::string_view a, std::string_view b, int32_t x, int32_t o, int32_t e, bidirectional_arena_t& arena, std::string& cigar);
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "wfa_simd.hpp"
+
+#include <string_view>
+
+namespace wfa {
+	//How many bases at each end of a and b an ends-free alignment may leave unaligned at no cost. All zero is a global alignment,
+	//free begins and ends on both sequences a local-in-both overlap, and a_begin = a_end = a.size() with the rest zero fits all of b somewhere inside a
+	struct ends_free_t {
+		int32_t a_begin;
+		int32_t a_end;
+		int32_t b_begin;
+		int32_t b_end;
+	};
+
+	//Aligns strings a and b with gap-affine penalties, skipping up to the given number of bases at the ends of each sequence for free.
+	//The first wavefront starts on every diagonal a free begin reaches, and the alignment ends on whichever diagonal first reaches the end of one sequence within the free end of the other
+	int32_t wavefront_ends_free(std::string_view a, std::string_view b, int32_t x, int32_t o, int32_t e, const ends_free_t& ends, wavefront_arena_t& arena);
+
+	//Ends-free alignment with manual vectorization
+	int32_t wavefront_ends_free_simd(std::string_view a, std::string_view b, int32_t x, int32_t o, int32_t e, const ends_free_t& ends, wavefront_arena_t& arena);
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "wfa_simd.hpp"
+
+#include <string_view>
+
+namespace wfa {
+	//Settings for extension alignment. Penalties only say how far the alignment can get, so reaching (v, h) with penalty s scores match * (v + h) - s, a matched pair of bases earning 2 * match.
+	//With diagonal set this is Z-drop: the threshold grows by e for every diagonal between a cell and the best one, so a long gap is not mistaken for the end of the homology
+	struct drop_t {
+		int32_t match;
+		int32_t threshold;
+		bool diagonal;
+	};
+
+	//The best point of an extension, a[0..a_length) aligned to b[0..b_length), and its score
+	struct extension_t {
+		int32_t score;
+		int32_t a_length;
+		int32_t b_length;
+	};
+
+	//Extends an alignment of a and b from their first bases, the end of an anchor, with gap-affine penalties. Every diagonal whose score falls more than the drop threshold below the best so far is dropped,
+	//and the extension stops once none are left within reach of the next wavefront. Uses the provided memory arena as it runs, keeping only the last max(x, o + e) wavefronts
+	extension_t wavefront_extension(std::string_view a, std::string_view b, int32_t x, int32_t o, int32_t e, const drop_t& drop, wavefront_arena_t& arena);
+
+	//Extension alignment with manual vectorization
+	extension_t wavefront_extension_simd(std::string_view a, std::string_view b, int32_t x, int32_t o, int32_t e, const drop_t& drop, wavefront_arena_t& arena);
+}
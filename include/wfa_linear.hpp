@@ -0,0 +1,28 @@
+#pragma once
+
+#include "wfa_simd.hpp"
+
+#include <string_view>
+
+namespace wfa {
+	//Gap-linear and edit-distance wavefronts have no separate insertion and deletion states, so they keep a single offset array, column 0, per score.
+	//The furthest offset on diagonal k at score s comes from a mismatch on k at s - x, or a gap on k - 1 or k + 1 at s - e
+
+	//The next gap-linear wavefront, with mismatch cost x and gap cost e per base
+	void next_linear(wavefront_t& wavefront, int32_t s, int32_t x, int32_t e);
+
+	//The next gap-linear wavefront, a vector of diagonals at a time
+	void next_linear_simd(wavefront_t& wavefront, int32_t s, int32_t x, int32_t e);
+
+	//Aligns strings a and b with mismatch cost x and a cost of e per inserted or deleted base. Uses the provided memory arena as it runs, keeping only the last max(x, e) wavefronts
+	int32_t wavefront_linear(std::string_view a, std::string_view b, int32_t x, int32_t e, wavefront_arena_t& arena);
+
+	//Gap-linear alignment with manual vectorization
+	int32_t wavefront_linear_simd(std::string_view a, std::string_view b, int32_t x, int32_t e, wavefront_arena_t& arena);
+
+	//The edit distance between a and b, as a negative score like the other algorithms. Gap-linear with both costs fixed at 1, so every wavefront only reads the one before it
+	int32_t wavefront_edit(std::string_view a, std::string_view b, wavefront_arena_t& arena);
+
+	//The edit distance with manual vectorization
+	int32_t wavefront_edit_simd(std::string_view a, std::string_view b, wavefront_arena_t& arena);
+}
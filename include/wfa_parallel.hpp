@@ -0,0 +1,20 @@
+#pragma once
+
+#include "wfa.hpp"
+
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace wfa {
+	//The memory reused between runs of the parallel algorithm, one arena per worker thread so workers never share an allocation
+	struct parallel_arena_t {
+		std::vector<wavefront_arena_t> arenas;
+	};
+
+	//Scores pairs on <threads> threads, 0 for one per hardware thread, the calling thread included. Each worker starts on its own contiguous share of the pairs and takes them a chunk at a time;
+	//once its share runs out it steals chunks from the shares of the other workers, so uneven pairs do not leave threads idle.
+	//Writes the score of pairs[i] to scores[i], which has to be at least as long as pairs
+	void wavefront_parallel(std::span<const std::pair<std::string, std::string>> pairs, int32_t x, int32_t o, int32_t e, parallel_arena_t& arena, std::span<int32_t> scores, int32_t threads = 0);
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "wfa_simd.hpp"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace wfa {
+	//Piggyback wavefronts store two more column sets after ins, del and match: the packed operations of each offset, then the block holding the operations before those
+	int32_t constexpr piggyback_ops = 3;
+	int32_t constexpr piggyback_prev = 6;
+	int32_t constexpr piggyback_columns = 9;
+
+	//The 2-bit operation codes packed into a block. Matches are not stored, the traceback finds them again by comparing the sequences.
+	//Extend continues the gap the previous operation opened, and so is the only operation not preceded by matches
+	int32_t constexpr op_extend = 0;
+	int32_t constexpr op_mismatch = 1;
+	int32_t constexpr op_insertion = 2;
+	int32_t constexpr op_deletion = 3;
+
+	//Up to 15 operations, 2 bits each and the newest in the lowest bits, below a sentinel bit marking where they begin.
+	//Offloaded from a diagonal once it fills, so the diagonal can start a new block
+	struct backtrace_block_t {
+		int32_t ops;
+		//Index of the block holding the operations before these, -1 for the first block
+		int32_t prev;
+	};
+
+	//The memory reused between runs of the piggyback algorithms
+	struct piggyback_arena_t {
+		//Only ever holds the last max(x, o + e) wavefronts, as the operations that led to them travel with the offsets
+		wavefront_arena_t wavefronts;
+		std::vector<backtrace_block_t> blocks;
+		//The packed operations of the final alignment, newest first
+		std::vector<int32_t> chain;
+	};
+
+	//next, also packing the operation that produced each offset onto the operations of its source
+	void next_piggyback(wavefront_t& wavefront, int32_t s, int32_t x, int32_t o, int32_t e);
+
+	//next_simd, also packing the operation that produced each offset onto the operations of its source
+	void next_simd_piggyback(wavefront_t& wavefront, int32_t s, int32_t x, int32_t o, int32_t e);
+
+	//Moves the operations of every full diagonal in the newest wavefront into blocks
+	void offload(wavefront_t& wavefront, std::vector<backtrace_block_t>& blocks);
+
+	//The wavefront alignment algorithm with traceback that keeps only the last max(x, o + e) wavefronts, rebuilding the alignment from the blocks instead. Writes the alignment into the caller-supplied cigar buffer, see wfa::backtrace
+	int32_t wavefront_piggyback(std::string_view a, std::string_view b, int32_t x, int32_t o, int32_t e, piggyback_arena_t& arena, std::string& cigar);
+
+	//The manually vectorized version of the above
+	int32_t wavefront_simd_piggyback(std::string_view a, std::string_view b, int32_t x, int32_t o, int32_t e, piggyback_arena_t& arena, std::string& cigar);
+}
@@ -26,15 +26,65 @@ namespace wfa {
 	using mask_type = Kokkos::Experimental::native_simd_mask<int32_t>;
 	using tag_type = Kokkos::Experimental::element_aligned_tag;
 
+	static_assert(simd_type::size() <= wavefront_guard, "a vector load must fit in the guard cells of a wavefront column");
+
 	//This function takes a wavefront entry, a column, a starting diagonal, and a scaling modifier to that diagonal (k + scaling), and will attempt to fill a vector register with the contents of the wavefront column entry in the range [k + scaling, k + scaling + simd_width). Out of bounds indicies are automatically handled, and replaced with -1 in the returned vector.
 	simd_type simd_lookup(wavefront_entry_t& t, int32_t column, int32_t k, int32_t scaling);
 
+	//simd_lookup as one unaligned load with no bounds checks. Only valid while [k + scaling, k + scaling + simd_width) lies within the guard cells around the column, that is in [t.low - wavefront_guard, t.high + wavefront_guard]
+	simd_type simd_load(wavefront_entry_t& t, int32_t column, int32_t k, int32_t scaling);
+
+	//The instruction sets the byte compare kernels of match_length_simd and the kernels of next_simd come in, narrowest first. scalar is the 64-bit word kernel of wfa::match_length, and next_simd on simd_type alone
+	enum class simd_level_t {
+		scalar,
+		sse2,
+		avx2,
+		avx512bw,
+	};
+
+	//The widest level the CPU and operating system support, read with cpuid. Always scalar off x86
+	simd_level_t detect_simd_level();
+
+	//The level match_length_simd, extend_simd and next_simd use. It is picked once at startup: the detected one, or the one the WFA_SIMD_LEVEL environment variable names if that is narrower
+	simd_level_t simd_level();
+
+	//Switches every thread to the given level, or to the detected one if the CPU lacks it, and returns the level now in use. For benchmarking the kernels against each other on one machine
+	simd_level_t set_simd_level(simd_level_t level);
+
+	//The level's name as WFA_SIMD_LEVEL takes it: scalar, sse2, avx2 or avx512bw
+	const char* simd_level_name(simd_level_t level);
+	//Reads a level name into level, returning false if it is not one
+	bool parse_simd_level(std::string_view name, simd_level_t& level);
+
+	//match_length with byte compares as wide as the CPU supports, see wfa::simd_level: AVX-512BW, AVX2 or SSE2 on x86, the 64-bit word kernel elsewhere. The tail is a masked compare on AVX-512 and a reread of the last register otherwise
+	int32_t match_length_simd(std::string_view a, int32_t v, std::string_view b, int32_t h);
+
+	//Extends every diagonal of the newest wavefront along its run of matches with the vector kernels of match_length_simd
 	bool extend_simd(wavefront_t& wavefront, std::string_view a, std::string_view b);
 
+	//Extends straight from packed sequences. One 64-bit compare already covers 32 bases, more than a vector of raw characters, so this shares the word kernel of wfa::extend
+	bool extend_simd(wavefront_t& wavefront, const packed_sequence_t& a, const packed_sequence_t& b);
+
 	void next_simd(wavefront_t& wavefront, int32_t s, int32_t x, int32_t o, int32_t e);
 
 	//The wavefront alignment algorithm implementation with manual vectorization. Aligns strings a and b with the provided substitution cost x, open cost o, and extend cost e. Uses the provided memory arena as it runs
 	int32_t wavefront_simd(std::string_view a, std::string_view b, int32_t x, int32_t o, int32_t e, wavefront_arena_t& arena);
 
+	//The manually vectorized wavefront alignment algorithm with traceback. Writes the alignment into the caller-supplied cigar buffer, see wfa::backtrace
+	int32_t wavefront_simd(std::string_view a, std::string_view b, int32_t x, int32_t o, int32_t e, wavefront_arena_t& arena, std::string& cigar);
+
+	//The manually vectorized wavefront alignment algorithm with adaptive wavefront reduction, see wfa::reduction_t
+	int32_t wavefront_simd(std::string_view a, std::string_view b, int32_t x, int32_t o, int32_t e, wavefront_arena_t& arena, const reduction_t& reduction);
+
+	//The manually vectorized wavefront alignment algorithm on packed sequences, see wfa::packed_sequence_t
+	int32_t wavefront_simd(const packed_sequence_t& a, const packed_sequence_t& b, int32_t x, int32_t o, int32_t e, wavefront_arena_t& arena);
+
+	//The manually vectorized wavefront alignment algorithm bounded by max_score, returning wfa::score_exceeded once the score would pass it
+	int32_t wavefront_simd(std::string_view a, std::string_view b, int32_t x, int32_t o, int32_t e, wavefront_arena_t& arena, int32_t max_score);
+
+	//The wavefront alignment algorithm with manual vectorization and the penalties fixed at compile time. Only instantiated for the sets in wfa::dispatch_penalties, which the overloads taking runtime penalties already pick automatically
+	template <int32_t X, int32_t O, int32_t E>
+	int32_t wavefront_simd(std::string_view a, std::string_view b, wavefront_arena_t& arena);
+
 
 }
\ No newline at end of file
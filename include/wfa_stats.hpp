@@ -0,0 +1,85 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+//Hot-path counters for wfa::wavefront and wfa::wavefront_simd. They are only compiled in with WFA_STATS defined (the WFA_STATS CMake option), otherwise WFA_STAT drops its statement and the kernels are unchanged
+#ifdef WFA_STATS
+#define WFA_STAT(...) __VA_ARGS__
+#else
+#define WFA_STAT(...)
+#endif
+
+namespace wfa {
+#ifdef WFA_STATS
+	constexpr bool stats_enabled = true;
+#else
+	constexpr bool stats_enabled = false;
+#endif
+
+	//What one thread's alignments did. Every field only grows, except arena_peak which is a maximum
+	struct stats_t {
+		uint64_t alignments = 0;
+		//Calls to next, one per score that has a wavefront
+		uint64_t scores = 0;
+		//Scores skipped with no wavefront, through wavefront_t::insert()
+		uint64_t null_wavefronts = 0;
+		//Diagonals computed by next, split into those done a vector at a time and those done one at a time. The scalar next computes all of its diagonals one at a time
+		uint64_t vector_diagonals = 0;
+		uint64_t scalar_diagonals = 0;
+		//Diagonals extend ran a match run on, and the characters compared along them, counting the mismatch that ends a run
+		uint64_t extended_diagonals = 0;
+		uint64_t characters = 0;
+		//The characters extend_simd compared a whole register at a time, and those left to the narrower tail compares
+		uint64_t vector_characters = 0;
+		uint64_t tail_characters = 0;
+		//The most int32_t a wavefront arena had handed out at once
+		uint64_t arena_peak = 0;
+		//Time spent in extend and next, in time stamp counter ticks on x86 and nanoseconds elsewhere
+		uint64_t extend_cycles = 0;
+		uint64_t next_cycles = 0;
+
+		stats_t& operator+=(const stats_t& rhs);
+	};
+
+	//Registers a new thread's counters, see wfa::thread_stats
+	stats_t& register_thread_stats();
+
+	//The calling thread's counters. Each thread counts into its own, so the hot path never synchronizes
+	inline stats_t& thread_stats() {
+		thread_local stats_t& stats = register_thread_stats();
+		return stats;
+	}
+
+	//The counters of every thread that has counted so far, including finished ones, in the order they started.
+	//Only read them once the threads are done aligning, e.g. after joining the workers
+	std::vector<stats_t> collect_stats();
+
+	//Zeroes the counters of every thread
+	void reset_stats();
+
+	//The counters of every thread and their total as JSON, {"enabled": ..., "total": {...}, "threads": [{...}, ...]}
+	std::string stats_json();
+
+	//The current value of the clock the cycle fields are measured in
+	inline uint64_t stats_clock() {
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+		return __rdtsc();
+#else
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+	}
+
+	//The characters a match run of length run compared, which includes the mismatch that ended it unless the run reached limit, the end of a sequence
+	inline uint64_t compared_characters(int32_t run, int32_t limit) {
+		return static_cast<uint64_t>(run) + (run < limit ? 1 : 0);
+	}
+}
@@ -0,0 +1,109 @@
+#include "include/alignment_output.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+void wfa::append_cigar(fmt::memory_buffer& out, std::string_view cigar) {
+	size_t i = 0;
+	while (i < cigar.size()) {
+		size_t run = i;
+		while (run < cigar.size() and cigar[run] == cigar[i]) {
+			++run;
+		}
+		fmt::format_to(std::back_inserter(out), "{}{}", run - i, cigar[i] == 'M' ? '=' : cigar[i]);
+		i = run;
+	}
+}
+
+//The NM tag, the number of operations that are not matches. Score-only alignments do not know it, so they leave it out
+static void append_edit_distance(fmt::memory_buffer& out, std::string_view cigar) {
+	if (not cigar.empty()) {
+		fmt::format_to(std::back_inserter(out), "\tNM:i:{}", cigar.size() - static_cast<size_t>(std::count(cigar.begin(), cigar.end(), 'M')));
+	}
+}
+
+void wfa::format_paf(fmt::memory_buffer& out, const alignment_record_t& record) {
+	int64_t matches = std::count(record.cigar.begin(), record.cigar.end(), 'M');
+	//Score-only alignments have no block length, the longer sequence stands in for it
+	size_t block = record.cigar.empty() ? static_cast<size_t>(std::max(record.a_length, record.b_length)) : record.cigar.size();
+	fmt::format_to(std::back_inserter(out), "{}\t{}\t0\t{}\t+\t{}\t{}\t0\t{}\t{}\t{}\t255",
+		record.b_name, record.b_length, record.b_length, record.a_name, record.a_length, record.a_length, matches, block);
+	append_edit_distance(out, record.cigar);
+	fmt::format_to(std::back_inserter(out), "\tAS:i:{}", record.score);
+	if (not record.cigar.empty()) {
+		fmt::format_to(std::back_inserter(out), "\tcg:Z:");
+		append_cigar(out, record.cigar);
+	}
+	out.push_back('\n');
+}
+
+void wfa::format_sam_header(fmt::memory_buffer& out) {
+	fmt::format_to(std::back_inserter(out), "@HD\tVN:1.6\tSO:unsorted\n");
+}
+
+void wfa::format_sam(fmt::memory_buffer& out, const alignment_record_t& record) {
+	fmt::format_to(std::back_inserter(out), "{}\t0\t{}\t1\t255\t", record.b_name, record.a_name);
+	if (record.cigar.empty()) {
+		out.push_back('*');
+	}
+	else {
+		append_cigar(out, record.cigar);
+	}
+	fmt::format_to(std::back_inserter(out), "\t*\t0\t0\t{}\t*", record.b_sequence.empty() ? std::string_view("*") : record.b_sequence);
+	append_edit_distance(out, record.cigar);
+	fmt::format_to(std::back_inserter(out), "\tAS:i:{}\n", record.score);
+}
+
+wfa::ordered_writer_t::ordered_writer_t(std::FILE* file, size_t max_pending) : file(file), max_pending(std::max<size_t>(max_pending, 1)), thread([this] { run(); }) {}
+
+wfa::ordered_writer_t::~ordered_writer_t() {
+	finish();
+}
+
+void wfa::ordered_writer_t::submit(size_t index, fmt::memory_buffer&& block) {
+	std::unique_lock lock(mutex);
+	//The block the writer is waiting for always goes in, otherwise a full queue of later blocks could never drain
+	space.wait(lock, [&] { return pending.size() < max_pending or index == next; });
+	pending.emplace(index, std::move(block));
+	if (index == next) {
+		ready.notify_one();
+	}
+}
+
+void wfa::ordered_writer_t::finish() {
+	{
+		std::lock_guard lock(mutex);
+		finished = true;
+	}
+	ready.notify_one();
+	if (thread.joinable()) {
+		thread.join();
+	}
+	std::fflush(file);
+}
+
+void wfa::ordered_writer_t::run() {
+	std::vector<fmt::memory_buffer> blocks;
+	while (true) {
+		{
+			std::unique_lock lock(mutex);
+			ready.wait(lock, [&] { return finished or pending.contains(next); });
+			//Takes every consecutive block that is ready, or after finish whatever is left
+			auto it = pending.begin();
+			while (it != pending.end() and (it->first == next or finished)) {
+				blocks.push_back(std::move(it->second));
+				it = pending.erase(it);
+				++next;
+			}
+			if (blocks.empty() and finished) {
+				return;
+			}
+		}
+		space.notify_all();
+		for (const auto& block : blocks) {
+			std::fwrite(block.data(), 1, block.size(), file);
+		}
+		blocks.clear();
+	}
+}
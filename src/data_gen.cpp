@@ -1,6 +1,10 @@
 #include "include/data_gen.hpp"
 #include <random>
 #include <array>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <thread>
 
 constexpr std::array<char, 4> nt = { 'A', 'T', 'G', 'C' };
 
@@ -42,4 +46,201 @@ std::vector<std::pair<std::string, std::string>> wfa::modify_sequences(int32_t l
 	}
 
 	return sequences;
-}
\ No newline at end of file
+}
+
+//splitmix64. Fast to seed, so every pair can get a generator of its own, and unlike the std distributions it draws the same numbers with every standard library
+struct pair_random_t {
+	uint64_t state;
+
+	static uint64_t mix(uint64_t z) {
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+		return z ^ (z >> 31);
+	}
+
+	uint64_t next() {
+		state += 0x9E3779B97F4A7C15;
+		return mix(state);
+	}
+
+	//In [0, 1)
+	double uniform() {
+		return static_cast<double>(next() >> 11) * 0x1.0p-53;
+	}
+
+	//In [0, n)
+	int32_t below(int32_t n) {
+		return static_cast<int32_t>((next() >> 32) * static_cast<uint64_t>(n) >> 32);
+	}
+
+	char base() {
+		return nt[next() >> 62];
+	}
+};
+
+static int32_t draw_length(pair_random_t& random, const wfa::read_model_t& model) {
+	int32_t length = model.length;
+	if (model.length_model == wfa::length_model_t::uniform) {
+		length += random.below(2 * model.length_spread + 1) - model.length_spread;
+	}
+	else if (model.length_model == wfa::length_model_t::normal) {
+		//Box-Muller, 1 - uniform keeps the logarithm away from 0
+		double radius = std::sqrt(-2.0 * std::log(1.0 - random.uniform()));
+		double angle = 2.0 * 3.14159265358979323846 * random.uniform();
+		length += static_cast<int32_t>(std::lround(model.length_spread * radius * std::cos(angle)));
+	}
+	return std::max(length, 1);
+}
+
+//A geometrically distributed length of at least 1 with the given mean
+static int32_t draw_indel_length(pair_random_t& random, int32_t mean) {
+	if (mean <= 1) {
+		return 1;
+	}
+	double failure = std::log(1.0 - random.uniform()) / std::log(1.0 - 1.0 / mean);
+	return 1 + static_cast<int32_t>(std::min(failure, 1e9));
+}
+
+//Appends pair index to out, the first sequence drawn at random and the second a copy of it with the model's errors
+static void generate_pair(const wfa::read_model_t& model, size_t index, std::string& out, std::vector<uint64_t>& lengths) {
+	pair_random_t random{ pair_random_t::mix(model.seed ^ pair_random_t::mix(index + 1)) };
+	int32_t length = draw_length(random, model);
+
+	//32 bases per draw
+	size_t a = out.size();
+	out.resize(a + length);
+	for (int32_t i = 0; i < length; i += 32) {
+		uint64_t bits = random.next();
+		for (int32_t j = i; j < std::min(i + 32, length); ++j, bits >>= 2) {
+			out[a + j] = nt[bits & 3];
+		}
+	}
+
+	//Positions in out, which appending the second sequence can move
+	size_t b = out.size();
+	int32_t run_begin = 0;
+	int32_t run_end = 0;
+	for (int32_t i = 0; i < length; ++i) {
+		char base = out[a + i];
+		if (i >= run_end) {
+			run_begin = i;
+			run_end = i + 1;
+			while (run_end < length and out[a + run_end] == base) {
+				++run_end;
+			}
+		}
+		bool homopolymer = run_end - run_begin >= model.homopolymer_length;
+		double indel_scale = homopolymer ? model.homopolymer_factor : 1.0;
+
+		double r = random.uniform();
+		if (r < model.long_indel_rate) {
+			int32_t indel = draw_indel_length(random, model.long_indel_length);
+			if (random.next() & 1) {
+				for (int32_t j = 0; j < indel; ++j) {
+					out.push_back(random.base());
+				}
+				out.push_back(base);
+			}
+			else {
+				i += std::min(indel, length - i) - 1;
+			}
+			continue;
+		}
+		r -= model.long_indel_rate;
+		if (r < model.deletion_rate * indel_scale) {
+			continue;
+		}
+		r -= model.deletion_rate * indel_scale;
+		if (r < model.insertion_rate * indel_scale) {
+			out.push_back(homopolymer ? base : random.base());
+			out.push_back(base);
+			continue;
+		}
+		r -= model.insertion_rate * indel_scale;
+		if (r < model.mismatch_rate) {
+			char substitute = random.base();
+			while (substitute == base) {
+				substitute = random.base();
+			}
+			out.push_back(substitute);
+			continue;
+		}
+		out.push_back(base);
+	}
+	lengths.push_back(static_cast<uint64_t>(length));
+	lengths.push_back(static_cast<uint64_t>(out.size() - b));
+}
+
+std::pair<std::string_view, std::string_view> wfa::generated_pairs_t::operator[](size_t i) const {
+	auto view = [&](size_t sequence) {
+		return std::string_view(bases.data() + offsets[sequence], offsets[sequence + 1] - offsets[sequence]);
+	};
+	return { view(2 * i), view(2 * i + 1) };
+}
+
+std::vector<std::pair<std::string, std::string>> wfa::generated_pairs_t::load() const {
+	std::vector<std::pair<std::string, std::string>> pairs;
+	pairs.reserve(size());
+	for (size_t i = 0; i < size(); ++i) {
+		auto [a, b] = (*this)[i];
+		pairs.emplace_back(a, b);
+	}
+	return pairs;
+}
+
+//The pairs a worker generates into a buffer of its own before they are gathered into one
+constexpr size_t chunk_size = 1024;
+
+wfa::generated_pairs_t wfa::generate_pairs(const read_model_t& model, size_t count, size_t threads) {
+	struct chunk_t {
+		std::string bases;
+		std::vector<uint64_t> lengths;
+	};
+	std::vector<chunk_t> chunks((count + chunk_size - 1) / chunk_size);
+
+	size_t workers = threads > 0 ? threads : std::max(std::thread::hardware_concurrency(), 1u);
+	workers = std::max<size_t>(std::min(workers, chunks.size()), 1);
+	std::atomic<size_t> next_chunk = 0;
+	auto work = [&] {
+		for (size_t chunk = next_chunk++; chunk < chunks.size(); chunk = next_chunk++) {
+			chunk_t& out = chunks[chunk];
+			out.lengths.reserve(2 * chunk_size);
+			for (size_t i = chunk * chunk_size; i < std::min((chunk + 1) * chunk_size, count); ++i) {
+				generate_pair(model, i, out.bases, out.lengths);
+			}
+		}
+	};
+	{
+		std::vector<std::jthread> pool;
+		for (size_t worker = 1; worker < workers; ++worker) {
+			pool.emplace_back(work);
+		}
+		work();
+	}
+
+	generated_pairs_t pairs;
+	pairs.offsets.reserve(2 * count + 1);
+	size_t total = 0;
+	for (const chunk_t& chunk : chunks) {
+		total += chunk.bases.size();
+	}
+	pairs.bases.reserve(total);
+	for (chunk_t& chunk : chunks) {
+		for (uint64_t length : chunk.lengths) {
+			pairs.offsets.push_back(pairs.offsets.back() + length);
+		}
+		pairs.bases.append(chunk.bases);
+		chunk = chunk_t{};
+	}
+	return pairs;
+}
+
+wfa::read_model_t wfa::error_model(int32_t length, double error_rate, uint64_t seed) {
+	read_model_t model;
+	model.seed = seed;
+	model.length = length;
+	model.mismatch_rate = error_rate / 3;
+	model.insertion_rate = error_rate / 3;
+	model.deletion_rate = error_rate / 3;
+	return model;
+}
@@ -37,6 +37,126 @@
     return std::max({dp[n][m][0], dp[n][m][1], dp[n][m][2]});
 }
 
+ int32_t wfa::naive_linear(std::string_view a, std::string_view b, int32_t x, int32_t e) {
+    size_t n = a.size(), m = b.size();
+    std::vector<std::vector<int32_t>> dp(n + 1, std::vector<int32_t>(m + 1, 0));
+
+    // First row and column are all gaps
+    for (size_t i = 1; i <= n; ++i) {
+        dp[i][0] = -e * static_cast<int32_t>(i);
+    }
+    for (size_t j = 1; j <= m; ++j) {
+        dp[0][j] = -e * static_cast<int32_t>(j);
+    }
+
+    for (size_t i = 1; i <= n; i++) {
+        for (size_t j = 1; j <= m; j++) {
+            int32_t cost = (a[i - 1] != b[j - 1]) ? -x : 0;
+            dp[i][j] = std::max({dp[i - 1][j - 1] + cost, dp[i][j - 1] - e, dp[i - 1][j] - e});
+        }
+    }
+
+    return dp[n][m];
+}
+
+ int32_t wfa::naive_affine2p(std::string_view a, std::string_view b, int32_t x, int32_t o1, int32_t e1, int32_t o2, int32_t e2) {
+    constexpr int32_t INF = static_cast<int32_t>(-1e9);
+    size_t n = a.size(), m = b.size();
+    std::vector<std::vector<std::array<int32_t, 5>>> dp(n + 1, std::vector<std::array<int32_t, 5>>(m + 1, {INF, INF, INF, INF, INF})); // M, I1, D1, I2, D2
+
+    dp[0][0][0] = 0;
+
+    // First column (deletions) and first row (insertions), with whichever model is cheaper
+    for (size_t i = 1; i <= n; ++i) {
+        dp[i][0][2] = -o1 - e1 * static_cast<int32_t>(i);
+        dp[i][0][4] = -o2 - e2 * static_cast<int32_t>(i);
+        dp[i][0][0] = std::max(dp[i][0][2], dp[i][0][4]);
+    }
+    for (size_t j = 1; j <= m; ++j) {
+        dp[0][j][1] = -o1 - e1 * static_cast<int32_t>(j);
+        dp[0][j][3] = -o2 - e2 * static_cast<int32_t>(j);
+        dp[0][j][0] = std::max(dp[0][j][1], dp[0][j][3]);
+    }
+
+    for (size_t i = 1; i <= n; i++) {
+        for (size_t j = 1; j <= m; j++) {
+            int32_t cost = (a[i - 1] != b[j - 1]) ? -x : 0;
+            dp[i][j][1] = std::max(dp[i][j - 1][0] - o1 - e1, dp[i][j - 1][1] - e1); // Insertion, first model
+            dp[i][j][2] = std::max(dp[i - 1][j][0] - o1 - e1, dp[i - 1][j][2] - e1); // Deletion, first model
+            dp[i][j][3] = std::max(dp[i][j - 1][0] - o2 - e2, dp[i][j - 1][3] - e2); // Insertion, second model
+            dp[i][j][4] = std::max(dp[i - 1][j][0] - o2 - e2, dp[i - 1][j][4] - e2); // Deletion, second model
+            dp[i][j][0] = std::max({dp[i - 1][j - 1][0] + cost, dp[i][j][1], dp[i][j][2], dp[i][j][3], dp[i][j][4]});
+        }
+    }
+
+    return dp[n][m][0];
+}
+
+int32_t wfa::naive_ends_free(std::string_view a, std::string_view b, int32_t x, int32_t o, int32_t e, int32_t a_begin, int32_t a_end, int32_t b_begin, int32_t b_end) {
+    constexpr int32_t INF = static_cast<int32_t>(-1e9);
+    int32_t n = static_cast<int32_t>(a.size()), m = static_cast<int32_t>(b.size());
+    std::vector<std::vector<std::array<int32_t, 3>>> dp(n + 1, std::vector<std::array<int32_t, 3>>(m + 1, {INF, INF, INF})); // M, I, D
+
+    dp[0][0][0] = 0;
+
+    // First column and first row, free up to a_begin and b_begin, gaps after that
+    for (int32_t i = 1; i <= n; ++i) {
+        dp[i][0][2] = std::max(dp[i - 1][0][0] - o - e, dp[i - 1][0][2] - e);
+        dp[i][0][0] = i <= a_begin ? 0 : dp[i][0][2];
+    }
+    for (int32_t j = 1; j <= m; ++j) {
+        dp[0][j][1] = std::max(dp[0][j - 1][0] - o - e, dp[0][j - 1][1] - e);
+        dp[0][j][0] = j <= b_begin ? 0 : dp[0][j][1];
+    }
+
+    for (int32_t i = 1; i <= n; i++) {
+        for (int32_t j = 1; j <= m; j++) {
+            int32_t cost = (a[i - 1] != b[j - 1]) ? -x : 0;
+            dp[i][j][1] = std::max(dp[i][j - 1][0] - o - e, dp[i][j - 1][1] - e); // Insertion
+            dp[i][j][2] = std::max(dp[i - 1][j][0] - o - e, dp[i - 1][j][2] - e); // Deletion
+            dp[i][j][0] = std::max({dp[i - 1][j - 1][0] + cost, dp[i][j][1], dp[i][j][2]});
+        }
+    }
+
+    // Best of the free ends of the last column and the last row
+    int32_t best = INF;
+    for (int32_t i = std::max(n - a_end, 0); i <= n; ++i) {
+        best = std::max(best, dp[i][m][0]);
+    }
+    for (int32_t j = std::max(m - b_end, 0); j <= m; ++j) {
+        best = std::max(best, dp[n][j][0]);
+    }
+    return best;
+}
+
+int32_t wfa::naive_extension(std::string_view a, std::string_view b, int32_t x, int32_t o, int32_t e, int32_t match) {
+    constexpr int32_t INF = static_cast<int32_t>(-1e9);
+    int32_t n = static_cast<int32_t>(a.size()), m = static_cast<int32_t>(b.size());
+    std::vector<std::vector<std::array<int32_t, 3>>> dp(n + 1, std::vector<std::array<int32_t, 3>>(m + 1, {INF, INF, INF})); // M, I, D
+
+    dp[0][0][0] = 0;
+    int32_t best = 0;
+
+    for (int32_t i = 0; i <= n; i++) {
+        for (int32_t j = 0; j <= m; j++) {
+            if (i > 0) {
+                dp[i][j][2] = std::max(dp[i - 1][j][0] - o - e, dp[i - 1][j][2] - e); // Deletion
+            }
+            if (j > 0) {
+                dp[i][j][1] = std::max(dp[i][j - 1][0] - o - e, dp[i][j - 1][1] - e); // Insertion
+            }
+            if (i > 0 and j > 0) {
+                int32_t cost = (a[i - 1] != b[j - 1]) ? -x : 0;
+                dp[i][j][0] = dp[i - 1][j - 1][0] + cost;
+            }
+            dp[i][j][0] = std::max({dp[i][j][0], dp[i][j][1], dp[i][j][2]});
+            best = std::max(best, match * (i + j) + dp[i][j][0]);
+        }
+    }
+
+    return best;
+}
+
  int32_t wfa::wavefront_dp(std::string_view a, std::string_view b,  int32_t x,  int32_t o,  int32_t e) {
      constexpr int32_t INF = static_cast<int32_t>(-1e9);  // Use large negative value to avoid overflow
     size_t n = a.size(), m = b.size();
@@ -0,0 +1,93 @@
+#include "include/packed_sequence.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+
+constexpr int32_t bases_per_word = 32;
+constexpr std::array<char, 4> decode = { 'A', 'C', 'G', 'T' };
+
+//The 2-bit code of a base, or -1 for anything that has to go in the side list
+static int32_t encode(char base) {
+	switch (base) {
+	case 'A': return 0;
+	case 'C': return 1;
+	case 'G': return 2;
+	case 'T': return 3;
+	default: return -1;
+	}
+}
+
+wfa::packed_sequence_t::packed_sequence_t(std::string_view sequence) {
+	assign(sequence);
+}
+
+void wfa::packed_sequence_t::assign(std::string_view sequence) {
+	length = static_cast<int32_t>(sequence.size());
+	words.assign(sequence.size() / bases_per_word + 2, 0);
+	ambiguous.clear();
+	ambiguous_bases.clear();
+	for (int32_t i = 0; i < length; ++i) {
+		int32_t code = encode(sequence[i]);
+		if (code == -1) {
+			ambiguous.push_back(i);
+			ambiguous_bases.push_back(sequence[i]);
+			code = 0;
+		}
+		words[i / bases_per_word] |= static_cast<uint64_t>(code) << (62 - 2 * (i % bases_per_word));
+	}
+}
+
+uint64_t wfa::packed_sequence_t::window(int32_t i) const {
+	size_t word = static_cast<size_t>(i / bases_per_word);
+	int32_t shift = 2 * (i % bases_per_word);
+	if (shift == 0) {
+		return words[word];
+	}
+	return (words[word] << shift) | (words[word + 1] >> (64 - shift));
+}
+
+char wfa::packed_sequence_t::at(int32_t i) const {
+	auto it = std::lower_bound(ambiguous.begin(), ambiguous.end(), i);
+	if (it != ambiguous.end() and *it == i) {
+		return ambiguous_bases[it - ambiguous.begin()];
+	}
+	return decode[(window(i) >> 62) & 3];
+}
+
+//The first position in [0, length) where the ambiguous bases of one sequence differ from the other sequence, or length if there is none
+static int32_t first_ambiguous_mismatch(const wfa::packed_sequence_t& self, int32_t start, const wfa::packed_sequence_t& other, int32_t other_start, int32_t length) {
+	auto it = std::lower_bound(self.ambiguous.begin(), self.ambiguous.end(), start);
+	for (; it != self.ambiguous.end() and *it < start + length; ++it) {
+		int32_t i = *it - start;
+		if (self.ambiguous_bases[it - self.ambiguous.begin()] != other.at(other_start + i)) {
+			return i;
+		}
+	}
+	return length;
+}
+
+int32_t wfa::match_length(const packed_sequence_t& a, int32_t v, const packed_sequence_t& b, int32_t h) {
+	int32_t limit = std::min(a.size() - v, b.size() - h);
+	if (limit <= 0) {
+		return 0;
+	}
+	int32_t length = 0;
+	while (length < limit) {
+		uint64_t difference = a.window(v + length) ^ b.window(h + length);
+		if (difference != 0) {
+			length += std::countl_zero(difference) / 2;
+			break;
+		}
+		length += bases_per_word;
+	}
+	length = std::min(length, limit);
+	//Ambiguous bases are packed as A, so within the run only their original characters can still mismatch
+	if (not a.ambiguous.empty()) {
+		length = first_ambiguous_mismatch(a, v, b, h, length);
+	}
+	if (not b.ambiguous.empty()) {
+		length = first_ambiguous_mismatch(b, h, a, v, length);
+	}
+	return length;
+}
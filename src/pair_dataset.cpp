@@ -0,0 +1,161 @@
+#include "include/pair_dataset.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+constexpr char magic[8] = { 'W', 'F', 'A', 'P', 'A', 'I', 'R', 'S' };
+constexpr uint32_t version = 1;
+constexpr uint64_t bases_per_word = 32;
+constexpr char decode_base[4] = { 'A', 'C', 'G', 'T' };
+
+//The 2-bit code of a base, or -1 if it can not be packed
+static int32_t encode(char base) {
+	switch (base) {
+	case 'A': return 0;
+	case 'C': return 1;
+	case 'G': return 2;
+	case 'T': return 3;
+	default: return -1;
+	}
+}
+
+//Collects sequences into the offsets index and the blob, then writes them out behind the header
+struct dataset_builder_t {
+	bool packed;
+	bool failed = false;
+	std::vector<uint64_t> offsets{ 0 };
+	std::string bytes{};
+	std::vector<uint64_t> words{};
+
+	void add(std::string_view sequence) {
+		uint64_t start = offsets.back();
+		offsets.push_back(start + sequence.size());
+		if (not packed) {
+			bytes.append(sequence);
+			return;
+		}
+		words.resize((offsets.back() + bases_per_word - 1) / bases_per_word, 0);
+		for (uint64_t i = 0; i < sequence.size(); ++i) {
+			int32_t code = encode(sequence[i]);
+			if (code == -1) {
+				failed = true;
+				return;
+			}
+			uint64_t base = start + i;
+			words[base / bases_per_word] |= static_cast<uint64_t>(code) << (62 - 2 * (base % bases_per_word));
+		}
+	}
+
+	bool write(const std::string& path) const {
+		if (failed) {
+			return false;
+		}
+		wfa::dataset_header_t header{};
+		std::memcpy(header.magic, magic, sizeof(magic));
+		header.version = version;
+		header.packed = packed ? 1 : 0;
+		header.pairs = (offsets.size() - 1) / 2;
+		header.blob_size = packed ? words.size() * sizeof(uint64_t) : bytes.size();
+
+		std::ofstream file(path, std::ios::binary);
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(offsets.data()), static_cast<std::streamsize>(offsets.size() * sizeof(uint64_t)));
+		if (packed) {
+			file.write(reinterpret_cast<const char*>(words.data()), static_cast<std::streamsize>(header.blob_size));
+		}
+		else {
+			file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+		}
+		return static_cast<bool>(file);
+	}
+};
+
+bool wfa::write_dataset(const std::string& path, std::span<const std::pair<std::string, std::string>> pairs, bool packed) {
+	dataset_builder_t builder{ packed };
+	for (const auto& [a, b] : pairs) {
+		builder.add(a);
+		builder.add(b);
+	}
+	return builder.write(path);
+}
+
+bool wfa::write_dataset(const std::string& path, pair_reader_t& reader, bool packed) {
+	dataset_builder_t builder{ packed };
+	sequence_record_t a;
+	sequence_record_t b;
+	while (reader.next(a, b)) {
+		builder.add(a.sequence);
+		builder.add(b.sequence);
+	}
+	return not reader.failed() and builder.write(path);
+}
+
+bool wfa::write_dataset(const std::string& path, const generated_pairs_t& pairs, bool packed) {
+	dataset_builder_t builder{ packed };
+	for (size_t i = 0; i < pairs.size(); ++i) {
+		auto [a, b] = pairs[i];
+		builder.add(a);
+		builder.add(b);
+	}
+	return builder.write(path);
+}
+
+wfa::pair_dataset_t::pair_dataset_t(const std::string& path) : file(path) {
+	if (not file.is_open() or file.size < sizeof(dataset_header_t)) {
+		return;
+	}
+	auto candidate = reinterpret_cast<const dataset_header_t*>(file.data);
+	if (std::memcmp(candidate->magic, magic, sizeof(magic)) != 0 or candidate->version != version) {
+		return;
+	}
+	//Checked before anything past the header is read, so a truncated file is refused rather than read out of bounds
+	uint64_t index_size = (2 * candidate->pairs + 1) * sizeof(uint64_t);
+	if (candidate->pairs > file.size or candidate->blob_size > file.size or file.size - sizeof(dataset_header_t) < index_size + candidate->blob_size) {
+		return;
+	}
+	auto index = reinterpret_cast<const uint64_t*>(file.data + sizeof(dataset_header_t));
+	if (index[0] != 0 or not std::is_sorted(index, index + 2 * candidate->pairs + 1)) {
+		return;
+	}
+	uint64_t bases = index[2 * candidate->pairs];
+	uint64_t expected = candidate->packed != 0 ? (bases + bases_per_word - 1) / bases_per_word * sizeof(uint64_t) : bases;
+	if (candidate->blob_size != expected) {
+		return;
+	}
+	header = candidate;
+	offsets = index;
+	blob = file.data + sizeof(dataset_header_t) + index_size;
+}
+
+std::pair<std::string_view, std::string_view> wfa::pair_dataset_t::operator[](size_t i) const {
+	auto view = [&](size_t sequence) {
+		return std::string_view(blob + offsets[sequence], offsets[sequence + 1] - offsets[sequence]);
+	};
+	return { view(2 * i), view(2 * i + 1) };
+}
+
+void wfa::pair_dataset_t::decode(size_t sequence, std::string& out) const {
+	out.clear();
+	if (not packed()) {
+		out.append(blob + offsets[sequence], offsets[sequence + 1] - offsets[sequence]);
+		return;
+	}
+	auto words = reinterpret_cast<const uint64_t*>(blob);
+	for (uint64_t base = offsets[sequence]; base < offsets[sequence + 1]; ++base) {
+		out.push_back(decode_base[(words[base / bases_per_word] >> (62 - 2 * (base % bases_per_word))) & 3]);
+	}
+}
+
+void wfa::pair_dataset_t::unpack(size_t i, std::string& a, std::string& b) const {
+	decode(2 * i, a);
+	decode(2 * i + 1, b);
+}
+
+std::vector<std::pair<std::string, std::string>> wfa::pair_dataset_t::load() const {
+	std::vector<std::pair<std::string, std::string>> pairs(size());
+	for (size_t i = 0; i < pairs.size(); ++i) {
+		unpack(i, pairs[i].first, pairs[i].second);
+	}
+	return pairs;
+}
@@ -0,0 +1,167 @@
+#include "include/sequence_reader.hpp"
+
+#include <utility>
+
+#ifdef _WIN32
+#include <fstream>
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+wfa::mapped_file_t::mapped_file_t(const std::string& path) {
+#ifdef _WIN32
+	std::ifstream file(path, std::ios::binary);
+	if (not file) {
+		return;
+	}
+	buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	data = buffer.data();
+	size = buffer.size();
+	open = true;
+#else
+	int descriptor = ::open(path.c_str(), O_RDONLY);
+	if (descriptor == -1) {
+		return;
+	}
+	struct stat status;
+	if (fstat(descriptor, &status) == 0) {
+		size = static_cast<size_t>(status.st_size);
+		if (size == 0) {
+			open = true;
+		}
+		else {
+			void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+			if (mapping != MAP_FAILED) {
+				//The parser reads front to back
+				madvise(mapping, size, MADV_SEQUENTIAL);
+				data = static_cast<const char*>(mapping);
+				open = true;
+			}
+			else {
+				size = 0;
+			}
+		}
+	}
+	//The mapping stays valid after the descriptor is closed
+	close(descriptor);
+#endif
+}
+
+wfa::mapped_file_t::~mapped_file_t() {
+#ifndef _WIN32
+	if (data != nullptr) {
+		munmap(const_cast<char*>(data), size);
+	}
+#endif
+}
+
+wfa::mapped_file_t::mapped_file_t(mapped_file_t&& rhs) noexcept {
+	*this = std::move(rhs);
+}
+
+wfa::mapped_file_t& wfa::mapped_file_t::operator=(mapped_file_t&& rhs) noexcept {
+	if (this != &rhs) {
+#ifdef _WIN32
+		buffer = std::move(rhs.buffer);
+		data = buffer.data();
+#else
+		if (data != nullptr) {
+			munmap(const_cast<char*>(data), size);
+		}
+		data = std::exchange(rhs.data, nullptr);
+#endif
+		size = std::exchange(rhs.size, 0);
+		open = std::exchange(rhs.open, false);
+	}
+	return *this;
+}
+
+//The line starting at position, without its line break, moving position past it
+static std::string_view read_line(std::string_view contents, size_t& position) {
+	size_t end = contents.find('\n', position);
+	if (end == std::string_view::npos) {
+		end = contents.size();
+	}
+	std::string_view line = contents.substr(position, end - position);
+	position = end == contents.size() ? end : end + 1;
+	if (not line.empty() and line.back() == '\r') {
+		line.remove_suffix(1);
+	}
+	return line;
+}
+
+//The header of a record up to the first whitespace, without its marker
+static std::string_view record_name(std::string_view header) {
+	header.remove_prefix(1);
+	size_t end = header.find_first_of(" \t");
+	return end == std::string_view::npos ? header : header.substr(0, end);
+}
+
+bool wfa::sequence_reader_t::next(sequence_record_t& record) {
+	//Blank lines between records are skipped
+	while (position < contents.size() and (contents[position] == '\n' or contents[position] == '\r')) {
+		++position;
+	}
+	if (position == contents.size() or failed) {
+		return false;
+	}
+
+	std::string_view header = read_line(contents, position);
+	record.name = record_name(header);
+	if (header.front() == '@') {
+		record.sequence = read_line(contents, position);
+		std::string_view separator = read_line(contents, position);
+		if (separator.empty() or separator.front() != '+') {
+			failed = true;
+			return false;
+		}
+		//The quality line is not needed, only skipped
+		read_line(contents, position);
+		return true;
+	}
+	if (header.front() != '>') {
+		failed = true;
+		return false;
+	}
+
+	record.sequence = std::string_view();
+	bool wrapped = false;
+	while (position < contents.size() and contents[position] != '>' and contents[position] != '@') {
+		std::string_view line = read_line(contents, position);
+		if (line.empty()) {
+			continue;
+		}
+		if (record.sequence.empty()) {
+			record.sequence = line;
+			continue;
+		}
+		if (not wrapped) {
+			joined.assign(record.sequence);
+			wrapped = true;
+		}
+		joined.append(line);
+	}
+	if (wrapped) {
+		record.sequence = joined;
+	}
+	return true;
+}
+
+bool wfa::pair_reader_t::next(sequence_record_t& first, sequence_record_t& second) {
+	if (not a.next(first)) {
+		return false;
+	}
+	if (not interleaved) {
+		return b.next(second);
+	}
+	//The second record of the pair reuses the reader's join buffer
+	if (first.sequence.data() == a.joined.data()) {
+		joined.assign(first.sequence);
+		first.sequence = joined;
+	}
+	return a.next(second);
+}
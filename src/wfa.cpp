@@ -1,37 +1,90 @@
 #include "include/wfa.hpp"
+#include "include/wfa_stats.hpp"
 
 #include "fmt/format.h"
 #include "fmt/ranges.h"
+#include <limits>
 #include <span>
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+#ifdef WFA_STATS
+//The int32_t handed out so far, counting every block before the current one as full
+static uint64_t in_use(const wfa::wavefront_arena_t& arena) {
+	uint64_t total = arena.current_index;
+	for (size_t block = 0; block < arena.current_block; ++block) {
+		total += arena.blocks[block].size;
+	}
+	return total;
+}
+#endif
 
 int32_t* wfa::wavefront_arena_t::alloc(size_t size) {
-	if (current_index + size > data.size()) {
-		data.resize(current_index + size);
+	//Moves on to the next block with room, adding one at the end once every block has been passed
+	while (current_block < blocks.size() and current_index + size > blocks[current_block].size) {
+		++current_block;
+		current_index = 0;
+	}
+	if (current_block == blocks.size()) {
+		size_t block = std::max(size, block_size);
+		blocks.push_back({ std::unique_ptr<int32_t[]>(new int32_t[block]), block });
 	}
-	int32_t* out = data.data() + current_index;
+	int32_t* out = blocks[current_block].data.get() + current_index;
 	current_index += size;
+	WFA_STAT(thread_stats().arena_peak = std::max(thread_stats().arena_peak, in_use(*this));)
 	return out;
 }
 
+void wfa::wavefront_arena_t::release(size_t size) {
+	current_index -= size;
+}
+
+void wfa::wavefront_arena_t::reset() {
+	current_block = 0;
+	current_index = 0;
+}
+
+size_t wfa::wavefront_arena_t::capacity() const {
+	size_t total = 0;
+	for (const block_t& block : blocks) {
+		total += block.size;
+	}
+	return total;
+}
+
 int32_t wfa::wavefront_entry_t::lookup(int32_t column, int32_t k) {
 	int32_t row = k - low;
 	if (row < 0 || row >= number_per_col) {
 		return -1;
 	}
-	return data[column * number_per_col + row];
+	return start_ptr(column)[row];
 }
 
 void wfa::wavefront_entry_t::set(int32_t column, int32_t k, int32_t val) {
 	int32_t row = k - low;
-	data[column * number_per_col + row] = val;
+	start_ptr(column)[row] = val;
 }
 
 int32_t& wfa::wavefront_entry_t::no_bound(int32_t column, int32_t row) {
-	return data[column * number_per_col + row];
+	return start_ptr(column)[row];
 }
 
 int32_t* wfa::wavefront_entry_t::start_ptr(int32_t column) {
-	return data.data() + column * number_per_col;
+	return data.data() + wavefront_guard + column * (number_per_col + wavefront_guard);
+}
+
+void wfa::wavefront_entry_t::fill_guards() {
+	std::fill(data.data(), data.data() + wavefront_guard, -1);
+	int32_t columns = static_cast<int32_t>((data.size() - wavefront_guard) / (number_per_col + wavefront_guard));
+	for (int32_t column = 0; column < columns; ++column) {
+		int32_t* end = start_ptr(column) + number_per_col;
+		std::fill(end, end + wavefront_guard, -1);
+	}
+}
+
+size_t wfa::wavefront_entry_t::allocation(int32_t number_per_col, int32_t columns) {
+	return static_cast<size_t>(wavefront_guard + columns * (number_per_col + wavefront_guard));
 }
 
 wfa::wavefront_entry_t::wavefront_entry_t(wavefront_entry_t&& rhs) {
@@ -49,23 +102,37 @@ wfa::wavefront_entry_t& wfa::wavefront_entry_t::operator=(wavefront_entry_t&& rh
 	return *this;
 }
 
-wfa::wavefront_entry_t::wavefront_entry_t(int32_t low, int32_t high, wavefront_arena_t& arena) : low(low), high(high), number_per_col(high - low + 1), data(arena.alloc(3 * number_per_col), 3 * number_per_col)/*, valid(true)*/ {
-	
+wfa::wavefront_entry_t::wavefront_entry_t(int32_t low, int32_t high, wavefront_arena_t& arena, int32_t columns) : low(low), high(high), number_per_col(high - low + 1), data(arena.alloc(allocation(number_per_col, columns)), allocation(number_per_col, columns))/*, valid(true)*/ {
+	fill_guards();
 }
 
 wfa::wavefront_entry_t::wavefront_entry_t() : low(0), high(0), number_per_col(high - low + 1)/*, valid(false)*/ {
 }
 
-int32_t wfa::wavefront_t::lookup(int32_t score, int32_t column, int32_t k) {
+int32_t wfa::wavefront_t::index(int32_t score) {
 	if (score < 0) {
 		return -1;
 	}
+	if (slots == 0) {
+		return mapping[score];
+	}
+	int32_t slot = score & (slots - 1);
+	return mapping[slot] == score ? slot : -1;
+}
+
+wfa::wavefront_entry_t& wfa::wavefront_t::newest() {
+	if (slots == 0) {
+		return views.back();
+	}
+	return views[(scores - 1) & (slots - 1)];
+}
 
-	int32_t index = mapping[score];
-	if (index == -1) {
+int32_t wfa::wavefront_t::lookup(int32_t score, int32_t column, int32_t k) {
+	int32_t i = index(score);
+	if (i == -1) {
 		return -1;
 	}
-	return views[index].lookup(column, k);
+	return views[i].lookup(column, k);
 }
 
 int32_t wfa::wavefront_t::wave_size_low(int32_t score) {
@@ -73,11 +140,11 @@ int32_t wfa::wavefront_t::wave_size_low(int32_t score) {
 	if (score < 0) {
 		return -1;
 	}
-	int32_t index = mapping[score];
-	if (index == -1) {
+	int32_t i = index(score);
+	if (i == -1) {
 		return 0;
 	}
-	return views[index].low;
+	return views[i].low;
 }
 
 int32_t wfa::wavefront_t::wave_size_high(int32_t score) {
@@ -85,36 +152,136 @@ int32_t wfa::wavefront_t::wave_size_high(int32_t score) {
 	if (score < 0) {
 		return -1;
 	}
-	int32_t index = mapping[score];
-	if (index == -1) {
+	int32_t i = index(score);
+	if (i == -1) {
 		return 0;
 	}
-	return views[index].high;
+	return views[i].high;
 }
 
 bool wfa::wavefront_t::valid_score(int32_t score) {
-	return score >= 0 && mapping[score] != -1;
+	return index(score) != -1;
+}
+
+//Moves the slots of the ring to a new stretch of the arena where each one holds at least <size> int32_t. Slots double in size, so this happens a logarithmic number of times
+static void grow_ring(wfa::wavefront_t& wavefront, size_t size) {
+	size_t slot_size = std::max(size, 2 * wavefront.slot_size);
+	int32_t* data = wavefront.arena.alloc(slot_size * wavefront.slots);
+	for (int32_t slot = 0; slot < wavefront.slots; ++slot) {
+		wfa::wavefront_entry_t& view = wavefront.views[slot];
+		int32_t* destination = data + slot * slot_size;
+		if (wavefront.mapping[slot] != -1) {
+			std::copy(view.data.begin(), view.data.end(), destination);
+		}
+		view.data = std::span<int32_t>(destination, view.data.size());
+	}
+	wavefront.ring_data = data;
+	wavefront.slot_size = slot_size;
+}
+
+void wfa::wavefront_t::ring(int32_t window) {
+	slots = static_cast<int32_t>(std::bit_ceil(static_cast<uint32_t>(window + 1)));
+	scores = 0;
+	views.clear();
+	views.resize(slots);
+	mapping.assign(slots, -1);
+	ring_data = nullptr;
+	slot_size = 0;
 }
 
 wfa::wavefront_entry_t& wfa::wavefront_t::insert(int32_t low, int32_t high) {
-	size_t before = arena.data.size();
-	auto& res = views.emplace_back(low, high, arena);
-	if (before != arena.data.size()) {
-		size_t i = 0;
-		for (auto& view : views) {
-			size_t view_size = 3 * view.number_per_col;
-			view.data = std::span<int32_t>(arena.data.data() + i, view_size);
-			i += view_size;
+	if (slots != 0) {
+		size_t size = wavefront_entry_t::allocation(high - low + 1, columns);
+		if (size > slot_size) {
+			grow_ring(*this, size);
 		}
+		int32_t slot = scores & (slots - 1);
+		wavefront_entry_t& res = views[slot];
+		res.low = low;
+		res.high = high;
+		res.number_per_col = high - low + 1;
+		res.data = std::span<int32_t>(ring_data + slot * slot_size, size);
+		res.fill_guards();
+		mapping[slot] = scores;
+		++scores;
+		return res;
 	}
+	auto& res = views.emplace_back(low, high, arena, columns);
 	mapping.emplace_back(static_cast<int32_t>(views.size()) - 1);
 	return res;
 }
 
 void wfa::wavefront_t::insert() {
+	WFA_STAT(++thread_stats().null_wavefronts;)
+	if (slots != 0) {
+		mapping[scores & (slots - 1)] = -1;
+		++scores;
+		return;
+	}
 	mapping.emplace_back(-1);
 }
 
+void wfa::wavefront_t::shrink(int32_t low, int32_t high) {
+	wavefront_entry_t& entry = newest();
+	int32_t number_per_col = high - low + 1;
+	int32_t first = low - entry.low;
+	//Columns only move towards the front, so copying them in order never overwrites one that has not been moved yet
+	for (int32_t column = 0; column < columns; ++column) {
+		int32_t* source = entry.start_ptr(column) + first;
+		int32_t* destination = entry.data.data() + wavefront_guard + column * (number_per_col + wavefront_guard);
+		if (destination != source) {
+			std::copy(source, source + number_per_col, destination);
+		}
+	}
+	size_t size = wavefront_entry_t::allocation(number_per_col, columns);
+	//A slot of the ring keeps its whole stretch of the arena
+	if (slots == 0) {
+		arena.release(entry.data.size() - size);
+	}
+	entry.data = entry.data.first(size);
+	entry.low = low;
+	entry.high = high;
+	entry.number_per_col = number_per_col;
+	//The moved columns left stale offsets where the new guard cells are
+	entry.fill_guards();
+}
+
+void wfa::wavefront_t::compact(int32_t window) {
+	int32_t first_live = std::max(static_cast<int32_t>(mapping.size()) - window, 0);
+	//Every view belongs to one score, so the oldest one is found by counting back from the newest
+	int32_t oldest = static_cast<int32_t>(mapping.size());
+	for (size_t seen = 0; seen < views.size(); ) {
+		--oldest;
+		if (mapping[oldest] != -1) {
+			++seen;
+		}
+	}
+
+	size_t live = 0;
+	arena.reset();
+	for (int32_t score = oldest; score < static_cast<int32_t>(mapping.size()); ++score) {
+		if (mapping[score] == -1) {
+			continue;
+		}
+		if (score < first_live) {
+			mapping[score] = -1;
+			continue;
+		}
+		//Live views are allocated again in the same order with fewer views before them, so each one lands no later in the arena than it was and moving them down never overwrites one that has not been moved yet
+		wavefront_entry_t& view = views[mapping[score]];
+		size_t view_size = view.data.size();
+		int32_t* destination = arena.alloc(view_size);
+		if (destination != view.data.data()) {
+			std::copy(view.data.begin(), view.data.end(), destination);
+		}
+		view.data = std::span<int32_t>(destination, view_size);
+		views[live] = std::move(view);
+		mapping[score] = static_cast<int32_t>(live);
+		++live;
+	}
+	views.resize(live);
+}
+
 void wfa::wavefront_t::print() {
 	/*for (const auto& pair : score_to_index) {
 		fmt::println("Score: {}", pair.first);
@@ -122,56 +289,115 @@ void wfa::wavefront_t::print() {
 	}*/
 }
 
+//The index of the first differing byte of two 8-byte words given their XOR, which must not be 0
+static int32_t first_difference(uint64_t difference) {
+	if constexpr (std::endian::native == std::endian::little) {
+		return std::countr_zero(difference) / 8;
+	}
+	else {
+		return std::countl_zero(difference) / 8;
+	}
+}
+
+static uint64_t load_word(const char* p) {
+	uint64_t word;
+	std::memcpy(&word, p, sizeof(word));
+	return word;
+}
+
+int32_t wfa::match_length_words(const char* a, const char* b, int32_t i, int32_t limit) {
+	for (; i + 8 <= limit; i += 8) {
+		uint64_t difference = load_word(a + i) ^ load_word(b + i);
+		if (difference != 0) {
+			return i + first_difference(difference);
+		}
+	}
+	if (i == limit) {
+		return limit;
+	}
+	if (limit >= 8) {
+		//Compare the last 8 bytes again. The ones before i are known to match, so the first difference is past them
+		int32_t last = limit - 8;
+		uint64_t difference = load_word(a + last) ^ load_word(b + last);
+		return difference != 0 ? last + first_difference(difference) : limit;
+	}
+	//Fewer than 8 bytes in total, copy just those into zeroed words so nothing past the end is read
+	uint64_t word_a = 0;
+	uint64_t word_b = 0;
+	std::memcpy(&word_a, a + i, static_cast<size_t>(limit - i));
+	std::memcpy(&word_b, b + i, static_cast<size_t>(limit - i));
+	uint64_t difference = word_a ^ word_b;
+	return difference != 0 ? i + first_difference(difference) : limit;
+}
+
+int32_t wfa::match_length(std::string_view a, int32_t v, std::string_view b, int32_t h) {
+	int32_t limit = std::min(static_cast<int32_t>(a.size()) - v, static_cast<int32_t>(b.size()) - h);
+	if (limit <= 0) {
+		return 0;
+	}
+	return match_length_words(a.data() + v, b.data() + h, 0, limit);
+}
+
 bool wfa::extend(wavefront_t& wavefront, std::string_view a, std::string_view b) {
-	wavefront_entry_t& entry = wavefront.views.back();
-	std::span<int32_t> matchfront_back(entry.data.data() + match * entry.number_per_col, entry.number_per_col);
+	wavefront_entry_t& entry = wavefront.newest();
+	int32_t* matchfront_back = entry.start_ptr(match);
+	WFA_STAT(stats_t& stats = thread_stats();)
 	for (int32_t k = entry.low; k < entry.high + 1; ++k) {
-		int32_t starting_index = matchfront_back[k - entry.low];
-		if (starting_index == -1) {
+		int32_t offset = matchfront_back[k - entry.low];
+		if (offset == -1) {
 			continue;
 		}
-		int32_t v = starting_index - k;
-		int32_t h = starting_index;
-		bool mismatch = false;
-		while (not mismatch) {
-			if (v >= static_cast<int32_t>(a.size()) or h >= static_cast<int32_t>(b.size())) {
-				break;
-			}
-			const char v_c = a[v];
-			const char h_c = b[h];
-			if (v_c == h_c) {
-				++starting_index;
-				++v;
-				++h;
-			}
-			else {
-				mismatch = true;
-			}
-		}
-		matchfront_back[k - entry.low] = starting_index;
+		int32_t run = match_length(a, offset - k, b, offset);
+		matchfront_back[k - entry.low] = offset + run;
+		WFA_STAT(++stats.extended_diagonals;)
+		WFA_STAT(stats.characters += compared_characters(run, std::min(static_cast<int32_t>(a.size()) - (offset - k), static_cast<int32_t>(b.size()) - offset));)
 	}
 	return false;
 }
 
-void wfa::next(wavefront_t& wavefront, int32_t s, int32_t x, int32_t o, int32_t e) {
-	int32_t m_high_sx = wavefront.wave_size_high(s - x);
-	int32_t m_low_sx = wavefront.wave_size_low(s - x);
-	int32_t m_high_soe = wavefront.wave_size_high(s - o - e);
-	int32_t m_low_soe = wavefront.wave_size_low(s - o - e);
-	int32_t i_high_se = wavefront.wave_size_high(s - e);
-	int32_t i_low_se = wavefront.wave_size_low(s - e);
-	int32_t d_high_se = wavefront.wave_size_high(s - e);
-	int32_t d_low_se = wavefront.wave_size_low(s - e);
-
+bool wfa::extend(wavefront_t& wavefront, const packed_sequence_t& a, const packed_sequence_t& b) {
+	wavefront_entry_t& entry = wavefront.newest();
+	int32_t* matchfront_back = entry.start_ptr(match);
+	WFA_STAT(stats_t& stats = thread_stats();)
+	for (int32_t k = entry.low; k < entry.high + 1; ++k) {
+		int32_t offset = matchfront_back[k - entry.low];
+		if (offset == -1) {
+			continue;
+		}
+		int32_t run = match_length(a, offset - k, b, offset);
+		matchfront_back[k - entry.low] = offset + run;
+		WFA_STAT(++stats.extended_diagonals;)
+		WFA_STAT(stats.characters += compared_characters(run, std::min(a.size() - (offset - k), b.size() - offset));)
+	}
+	return false;
+}
 
-	int32_t high = std::max({ m_high_sx, m_high_soe, i_high_se, d_high_se }) + 1;
-	int32_t low = std::min({ m_low_sx, m_low_soe, i_low_se, d_low_se }) - 1;
-	if (s < o + e) {
-		high = 0;
-		low = 0;
+//The next wavefront for penalties of either type, see wfa::penalties_t and wfa::fixed_penalties_t
+template <typename penalty_t>
+static void next_step(wfa::wavefront_t& wavefront, int32_t s, const penalty_t& p) {
+	using namespace wfa;
+	const int32_t x = p.x;
+	const int32_t o = p.o;
+	const int32_t e = p.e;
+	//The new wavefront spans the diagonals reachable from the source wavefronts that exist
+	int32_t high = std::numeric_limits<int32_t>::min();
+	int32_t low = std::numeric_limits<int32_t>::max();
+	if (wavefront.valid_score(s - x)) {
+		high = std::max(high, wavefront.wave_size_high(s - x));
+		low = std::min(low, wavefront.wave_size_low(s - x));
+	}
+	if (wavefront.valid_score(s - o - e)) {
+		high = std::max(high, wavefront.wave_size_high(s - o - e) + 1);
+		low = std::min(low, wavefront.wave_size_low(s - o - e) - 1);
+	}
+	if (wavefront.valid_score(s - e)) {
+		high = std::max(high, wavefront.wave_size_high(s - e) + 1);
+		low = std::min(low, wavefront.wave_size_low(s - e) - 1);
 	}
 
 	auto& wave_cur = wavefront.insert(low, high);
+	WFA_STAT(++thread_stats().scores;)
+	WFA_STAT(thread_stats().scalar_diagonals += high - low + 1;)
 
 	for (int32_t k = low; k < high + 1; ++k) {
 		wave_cur.no_bound(ins, k - low) = std::max({ wavefront.lookup(s - o - e, match, k - 1), wavefront.lookup(s - e, ins, k - 1) });
@@ -190,12 +416,128 @@ void wfa::next(wavefront_t& wavefront, int32_t s, int32_t x, int32_t o, int32_t
 	}
 }
 
-int32_t wfa::wavefront(std::string_view a, std::string_view b, int32_t x, int32_t o, int32_t e, wavefront_arena_t& arena) {
-	wavefront_t wavefront(arena);
+void wfa::next(wavefront_t& wavefront, int32_t s, int32_t x, int32_t o, int32_t e) {
+	next_step(wavefront, s, penalties_t{ x, o, e });
+}
+
+void wfa::reduce(wavefront_t& wavefront, int32_t n, int32_t m, const reduction_t& reduction) {
+	wavefront_entry_t& entry = wavefront.newest();
+	if (entry.number_per_col < reduction.min_wavefront_length) {
+		return;
+	}
+	//How far a diagonal is from the end of the alignment, from its furthest offset in any column that is still inside the sequences. A match offset can step past the end
+	//while a gap on the same diagonal is still inside them and on the optimal path, so the gap columns count too. Diagonals with no offset inside the sequences can not reach the end at all
+	auto distance = [&](int32_t k) {
+		int32_t furthest = -1;
+		for (int32_t column : { match, ins, del }) {
+			int32_t h = entry.lookup(column, k);
+			int32_t v = h - k;
+			if (h != -1 and h <= m and v <= n and v >= 0) {
+				furthest = std::max(furthest, h);
+			}
+		}
+		if (furthest == -1) {
+			return std::numeric_limits<int32_t>::max();
+		}
+		return std::max(n - (furthest - k), m - furthest);
+	};
+
+	int32_t closest = std::numeric_limits<int32_t>::max();
+	for (int32_t k = entry.low; k < entry.high + 1; ++k) {
+		closest = std::min(closest, distance(k));
+	}
+	if (closest == std::numeric_limits<int32_t>::max()) {
+		return;
+	}
+	//The closest diagonal always stays, so neither end can pass it
+	int32_t low = entry.low;
+	while (distance(low) - closest > reduction.max_distance_threshold) {
+		++low;
+	}
+	int32_t high = entry.high;
+	while (distance(high) - closest > reduction.max_distance_threshold) {
+		--high;
+	}
+	if (low != entry.low or high != entry.high) {
+		wavefront.shrink(low, high);
+	}
+}
+
+void wfa::backtrace(wavefront_t& wavefront, std::string_view a, std::string_view b, int32_t score, int32_t x, int32_t o, int32_t e, std::string& cigar, int32_t begin, int32_t end) {
+	cigar.clear();
+
+	int32_t s = score;
+	int32_t k = static_cast<int32_t>(b.size()) - static_cast<int32_t>(a.size());
+	int32_t offset = static_cast<int32_t>(b.size());
+	int32_t column = end;
+
+	//Operations are written back to front, and reversed at the end
+	while (true) {
+		if (s == 0 and column == begin) {
+			cigar.append(offset, 'M');
+			break;
+		}
+		if (column == match) {
+			int32_t mismatch = wavefront.lookup(s - x, match, k);
+			if (mismatch != -1) {
+				++mismatch;
+			}
+			int32_t insertion = wavefront.lookup(s, ins, k);
+			int32_t deletion = wavefront.lookup(s, del, k);
+			int32_t source = std::max({ mismatch, insertion, deletion });
+
+			cigar.append(offset - source, 'M');
+			offset = source;
+			if (source == mismatch) {
+				cigar.push_back('X');
+				--offset;
+				s -= x;
+			}
+			else if (source == insertion) {
+				column = ins;
+			}
+			else {
+				column = del;
+			}
+		}
+		else if (column == ins) {
+			cigar.push_back('I');
+			--offset;
+			--k;
+			if (wavefront.lookup(s - o - e, match, k) == offset) {
+				s -= o + e;
+				column = match;
+			}
+			else {
+				s -= e;
+			}
+		}
+		else {
+			cigar.push_back('D');
+			++k;
+			if (wavefront.lookup(s - o - e, match, k) == offset) {
+				s -= o + e;
+				column = match;
+			}
+			else {
+				s -= e;
+			}
+		}
+	}
+	std::reverse(cigar.begin(), cigar.end());
+}
+
+//Runs the alignment, with the adaptive reduction heuristic unless reduction is null. Returns -1 once the next score would pass max_score. sequence_t is std::string_view or wfa::packed_sequence_t, penalty_t is wfa::penalties_t or a wfa::fixed_penalties_t
+template <typename sequence_t, typename penalty_t>
+static int32_t align(wfa::wavefront_t& wavefront, const sequence_t& a, const sequence_t& b, const penalty_t& p, const wfa::reduction_t* reduction, int32_t max_score = std::numeric_limits<int32_t>::max()) {
+	using namespace wfa;
+	const int32_t x = p.x;
+	const int32_t o = p.o;
+	const int32_t e = p.e;
 	auto& first = wavefront.insert(0,0);
-	first.data[0] = -1;
-	first.data[1] = -1;
-	first.data[2] = 0;
+	first.no_bound(ins, 0) = -1;
+	first.no_bound(del, 0) = -1;
+	first.no_bound(match, 0) = 0;
 
 	bool matched = false;
 
@@ -204,13 +546,19 @@ int32_t wfa::wavefront(std::string_view a, std::string_view b, int32_t x, int32_
 	int32_t final_k = static_cast<int32_t>(b.size()) - static_cast<int32_t>(a.size());
 	int32_t final_offset = static_cast<int32_t>(b.size());
 
+	WFA_STAT(++thread_stats().alignments;)
 	while (not matched) {
+		WFA_STAT(uint64_t extend_start = stats_clock();)
 		/*matched =*/ extend(wavefront, a, b);
-		auto& matchfront_back = wavefront.views.back();
+		WFA_STAT(thread_stats().extend_cycles += stats_clock() - extend_start;)
+		auto& matchfront_back = wavefront.newest();
 		if (matchfront_back.lookup(match, final_k) >= final_offset) {
 			break;
 		}
 		else {
+			if (reduction != nullptr) {
+				reduce(wavefront, static_cast<int32_t>(a.size()), static_cast<int32_t>(b.size()), *reduction);
+			}
 			score = score + 1;
 			while (not (
 				wavefront.valid_score(score - x)
@@ -221,10 +569,67 @@ int32_t wfa::wavefront(std::string_view a, std::string_view b, int32_t x, int32_
 				wavefront.insert();
 				++score;
 			}
+			if (score > max_score) {
+				return -1;
+			}
 		}
-		next(wavefront, score, x, o, e);
+		WFA_STAT(uint64_t next_start = stats_clock();)
+		next_step(wavefront, score, p);
+		WFA_STAT(thread_stats().next_cycles += stats_clock() - next_start;)
+	}
+	return score;
+}
 
+int32_t wfa::wavefront(std::string_view a, std::string_view b, int32_t x, int32_t o, int32_t e, wavefront_arena_t& arena) {
+	wavefront_t wavefront(arena);
+	wavefront.ring(std::max(x, o + e));
+	int32_t score = dispatch_penalties(x, o, e, [&](auto p) { return align(wavefront, a, b, p, nullptr); });
+	arena.reset();
+	return -1 * score;
+}
+
+int32_t wfa::wavefront(std::string_view a, std::string_view b, int32_t x, int32_t o, int32_t e, wavefront_arena_t& arena, std::string& cigar) {
+	wavefront_t wavefront(arena);
+	int32_t score = dispatch_penalties(x, o, e, [&](auto p) { return align(wavefront, a, b, p, nullptr); });
+	backtrace(wavefront, a, b, score, x, o, e, cigar);
+	arena.reset();
+	return -1 * score;
+}
+
+int32_t wfa::wavefront(std::string_view a, std::string_view b, int32_t x, int32_t o, int32_t e, wavefront_arena_t& arena, const reduction_t& reduction) {
+	wavefront_t wavefront(arena);
+	wavefront.ring(std::max(x, o + e));
+	int32_t score = dispatch_penalties(x, o, e, [&](auto p) { return align(wavefront, a, b, p, &reduction); });
+	arena.reset();
+	return -1 * score;
+}
+
+int32_t wfa::wavefront(const packed_sequence_t& a, const packed_sequence_t& b, int32_t x, int32_t o, int32_t e, wavefront_arena_t& arena) {
+	wavefront_t wavefront(arena);
+	wavefront.ring(std::max(x, o + e));
+	int32_t score = dispatch_penalties(x, o, e, [&](auto p) { return align(wavefront, a, b, p, nullptr); });
+	arena.reset();
+	return -1 * score;
+}
+int32_t wfa::wavefront(std::string_view a, std::string_view b, int32_t x, int32_t o, int32_t e, wavefront_arena_t& arena, int32_t max_score) {
+	wavefront_t wavefront(arena);
+	wavefront.ring(std::max(x, o + e));
+	int32_t score = dispatch_penalties(x, o, e, [&](auto p) { return align(wavefront, a, b, p, nullptr, max_score); });
+	arena.reset();
+	if (score == -1) {
+		return score_exceeded;
 	}
-	arena.current_index = 0;
 	return -1 * score;
-}
\ No newline at end of file
+}
+
+template <int32_t X, int32_t O, int32_t E>
+int32_t wfa::wavefront(std::string_view a, std::string_view b, wavefront_arena_t& arena) {
+	wavefront_t wavefront(arena);
+	wavefront.ring(std::max(X, O + E));
+	int32_t score = align(wavefront, a, b, fixed_penalties_t<X, O, E>{}, nullptr);
+	arena.reset();
+	return -1 * score;
+}
+
+template int32_t wfa::wavefront<4, 6, 2>(std::string_view a, std::string_view b, wavefront_arena_t& arena);
+template int32_t wfa::wavefront<2, 3, 1>(std::string_view a, std::string_view b, wavefront_arena_t& arena);
@@ -0,0 +1,175 @@
+#include "include/wfa_affine2p.hpp"
+
+#include <algorithm>
+#include <limits>
+
+//The wavefronts one step of the two-piece recurrences reads. Any of them may be null
+struct sources_t {
+	wfa::wavefront_entry_t* mismatch;
+	wfa::wavefront_entry_t* open1;
+	wfa::wavefront_entry_t* extend1;
+	wfa::wavefront_entry_t* open2;
+	wfa::wavefront_entry_t* extend2;
+};
+
+static wfa::wavefront_entry_t* source(wfa::wavefront_t& wavefront, int32_t score) {
+	int32_t index = wavefront.index(score);
+	return index == -1 ? nullptr : &wavefront.views[index];
+}
+
+static int32_t get(wfa::wavefront_entry_t* entry, int32_t column, int32_t k) {
+	return entry == nullptr ? -1 : entry->lookup(column, k);
+}
+
+static wfa::simd_type get_simd(wfa::wavefront_entry_t* entry, int32_t column, int32_t k, int32_t scaling) {
+	return entry == nullptr ? wfa::simd_type(-1) : wfa::simd_lookup(*entry, column, k, scaling);
+}
+
+//Inserts the wavefront of score s, spanning every diagonal its sources reach, and fills in the sources
+static wfa::wavefront_entry_t& insert(wfa::wavefront_t& wavefront, int32_t s, const wfa::affine2p_penalties_t& p, sources_t& sources) {
+	int32_t high = std::numeric_limits<int32_t>::min();
+	int32_t low = std::numeric_limits<int32_t>::max();
+	if (wavefront.valid_score(s - p.x)) {
+		high = std::max(high, wavefront.wave_size_high(s - p.x));
+		low = std::min(low, wavefront.wave_size_low(s - p.x));
+	}
+	for (int32_t gap : { s - p.o1 - p.e1, s - p.e1, s - p.o2 - p.e2, s - p.e2 }) {
+		if (wavefront.valid_score(gap)) {
+			high = std::max(high, wavefront.wave_size_high(gap) + 1);
+			low = std::min(low, wavefront.wave_size_low(gap) - 1);
+		}
+	}
+	wfa::wavefront_entry_t& wave_cur = wavefront.insert(low, high);
+	//Only looked up now, as inserting into a ring can move the other wavefronts
+	sources.mismatch = source(wavefront, s - p.x);
+	sources.open1 = source(wavefront, s - p.o1 - p.e1);
+	sources.extend1 = source(wavefront, s - p.e1);
+	sources.open2 = source(wavefront, s - p.o2 - p.e2);
+	sources.extend2 = source(wavefront, s - p.e2);
+	return wave_cur;
+}
+
+//Fills diagonal k of the new wavefront one value at a time
+static void cell(wfa::wavefront_entry_t& wave_cur, const sources_t& sources, int32_t k) {
+	using namespace wfa;
+	int32_t row = k - wave_cur.low;
+	int32_t I1 = std::max(get(sources.open1, match, k - 1), get(sources.extend1, ins, k - 1));
+	if (I1 != -1) {
+		++I1;
+	}
+	int32_t D1 = std::max(get(sources.open1, match, k + 1), get(sources.extend1, del, k + 1));
+	int32_t I2 = std::max(get(sources.open2, match, k - 1), get(sources.extend2, ins2, k - 1));
+	if (I2 != -1) {
+		++I2;
+	}
+	int32_t D2 = std::max(get(sources.open2, match, k + 1), get(sources.extend2, del2, k + 1));
+	int32_t X = get(sources.mismatch, match, k);
+	if (X != -1) {
+		++X;
+	}
+	wave_cur.no_bound(ins, row) = I1;
+	wave_cur.no_bound(del, row) = D1;
+	wave_cur.no_bound(ins2, row) = I2;
+	wave_cur.no_bound(del2, row) = D2;
+	wave_cur.no_bound(match, row) = std::max({ X, I1, D1, I2, D2 });
+}
+
+void wfa::next_affine2p(wavefront_t& wavefront, int32_t s, const affine2p_penalties_t& penalties) {
+	sources_t sources;
+	wavefront_entry_t& wave_cur = insert(wavefront, s, penalties, sources);
+	for (int32_t k = wave_cur.low; k < wave_cur.high + 1; ++k) {
+		cell(wave_cur, sources, k);
+	}
+}
+
+void wfa::next_affine2p_simd(wavefront_t& wavefront, int32_t s, const affine2p_penalties_t& penalties) {
+	sources_t sources;
+	wavefront_entry_t& wave_cur = insert(wavefront, s, penalties, sources);
+	int32_t low = wave_cur.low;
+	int32_t high = wave_cur.high;
+
+	constexpr int32_t simd_size = static_cast<int32_t>(simd_type::size());
+
+	int32_t k = low;
+	while (high - k + 1 > simd_size) {
+		simd_type I1 = Kokkos::max(get_simd(sources.open1, match, k, -1), get_simd(sources.extend1, ins, k, -1));
+		Kokkos::Experimental::where(I1 != -1, I1) = I1 + 1;
+		simd_type D1 = Kokkos::max(get_simd(sources.open1, match, k, +1), get_simd(sources.extend1, del, k, +1));
+
+		simd_type I2 = Kokkos::max(get_simd(sources.open2, match, k, -1), get_simd(sources.extend2, ins2, k, -1));
+		Kokkos::Experimental::where(I2 != -1, I2) = I2 + 1;
+		simd_type D2 = Kokkos::max(get_simd(sources.open2, match, k, +1), get_simd(sources.extend2, del2, k, +1));
+
+		simd_type X = get_simd(sources.mismatch, match, k, 0);
+		Kokkos::Experimental::where(X != -1, X) = X + 1;
+
+		simd_type M = Kokkos::max(Kokkos::max(I1, D1), Kokkos::max(I2, D2));
+		M = Kokkos::max(M, X);
+
+		I1.copy_to(wave_cur.start_ptr(ins) + (k - low), tag_type());
+		D1.copy_to(wave_cur.start_ptr(del) + (k - low), tag_type());
+		I2.copy_to(wave_cur.start_ptr(ins2) + (k - low), tag_type());
+		D2.copy_to(wave_cur.start_ptr(del2) + (k - low), tag_type());
+		M.copy_to(wave_cur.start_ptr(match) + (k - low), tag_type());
+
+		k += simd_size;
+	}
+
+	for (; k < high + 1; ++k) {
+		cell(wave_cur, sources, k);
+	}
+}
+
+template <bool simd>
+static int32_t align(wfa::wavefront_arena_t& arena, std::string_view a, std::string_view b, const wfa::affine2p_penalties_t& p) {
+	using namespace wfa;
+	wavefront_t wavefront(arena, affine2p_columns);
+	wavefront.ring(std::max({ p.x, p.o1 + p.e1, p.o2 + p.e2 }));
+	auto& first = wavefront.insert(0, 0);
+	std::fill(first.data.begin(), first.data.end(), -1);
+	first.no_bound(match, 0) = 0;
+
+	int32_t score = 0;
+	int32_t final_k = static_cast<int32_t>(b.size()) - static_cast<int32_t>(a.size());
+	int32_t final_offset = static_cast<int32_t>(b.size());
+
+	while (true) {
+		if constexpr (simd) {
+			extend_simd(wavefront, a, b);
+		}
+		else {
+			extend(wavefront, a, b);
+		}
+		if (wavefront.newest().lookup(match, final_k) >= final_offset) {
+			break;
+		}
+
+		++score;
+		while (not (
+			wavefront.valid_score(score - p.x)
+			or wavefront.valid_score(score - p.o1 - p.e1)
+			or wavefront.valid_score(score - p.e1)
+			or wavefront.valid_score(score - p.o2 - p.e2)
+			or wavefront.valid_score(score - p.e2)
+		)) {
+			wavefront.insert();
+			++score;
+		}
+		if constexpr (simd) {
+			next_affine2p_simd(wavefront, score, p);
+		}
+		else {
+			next_affine2p(wavefront, score, p);
+		}
+	}
+	arena.reset();
+	return -1 * score;
+}
+
+int32_t wfa::wavefront_affine2p(std::string_view a, std::string_view b, const affine2p_penalties_t& penalties, wavefront_arena_t& arena) {
+	return align<false>(arena, a, b, penalties);
+}
+
+int32_t wfa::wavefront_affine2p_simd(std::string_view a, std::string_view b, const affine2p_penalties_t& penalties, wavefront_arena_t& arena) {
+	return align<true>(arena, a, b, penalties);
+}
@@ -0,0 +1,173 @@
+#include "include/wfa_batch.hpp"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+
+constexpr int32_t lanes = static_cast<int32_t>(wfa::simd_type::size());
+
+//The pairs of one group of lanes. Lanes past the end of the batch have no pair and start out finished
+struct group_t {
+	std::array<std::string_view, lanes> a;
+	std::array<std::string_view, lanes> b;
+	std::array<bool, lanes> active;
+};
+
+static wfa::batch_wavefront_t& slot(wfa::batch_arena_t& arena, int32_t score) {
+	return arena.ring[score % arena.ring.size()];
+}
+
+//Returns the wavefront of the given score, or null if the score has none or it has already been overwritten
+static wfa::batch_wavefront_t* source(wfa::batch_arena_t& arena, int32_t score) {
+	if (score < 0) {
+		return nullptr;
+	}
+	wfa::batch_wavefront_t& wavefront = slot(arena, score);
+	if (wavefront.score != score or not wavefront.valid) {
+		return nullptr;
+	}
+	return &wavefront;
+}
+
+//Diagonal k of a column for every lane, or -1 in every lane if the wavefront does not cover it
+static wfa::simd_type get(wfa::batch_wavefront_t* wavefront, int32_t column, int32_t k) {
+	if (wavefront == nullptr or k < wavefront->low or k > wavefront->high) {
+		return wfa::simd_type(-1);
+	}
+	return wavefront->data[column * (wavefront->high - wavefront->low + 1) + k - wavefront->low];
+}
+
+static void next(wfa::batch_arena_t& arena, int32_t s, int32_t x, int32_t o, int32_t e) {
+	using namespace wfa;
+	batch_wavefront_t* sx = source(arena, s - x);
+	batch_wavefront_t* soe = source(arena, s - o - e);
+	batch_wavefront_t* se = source(arena, s - e);
+
+	int32_t high = std::numeric_limits<int32_t>::min();
+	int32_t low = std::numeric_limits<int32_t>::max();
+	if (sx != nullptr) {
+		high = std::max(high, sx->high);
+		low = std::min(low, sx->low);
+	}
+	if (soe != nullptr) {
+		high = std::max(high, soe->high + 1);
+		low = std::min(low, soe->low - 1);
+	}
+	if (se != nullptr) {
+		high = std::max(high, se->high + 1);
+		low = std::min(low, se->low - 1);
+	}
+
+	//The ring holds one more wavefront than next reads from, so this never overwrites a source
+	batch_wavefront_t& wave_cur = slot(arena, s);
+	wave_cur.score = s;
+	wave_cur.valid = true;
+	wave_cur.low = low;
+	wave_cur.high = high;
+	int32_t number_per_col = high - low + 1;
+	wave_cur.data.resize(3 * number_per_col);
+
+	for (int32_t k = low; k < high + 1; ++k) {
+		simd_type I = Kokkos::max(get(soe, match, k - 1), get(se, ins, k - 1));
+		Kokkos::Experimental::where(I != -1, I) = I + 1;
+
+		simd_type D = Kokkos::max(get(soe, match, k + 1), get(se, del, k + 1));
+
+		simd_type X = get(sx, match, k);
+		Kokkos::Experimental::where(X != -1, X) = X + 1;
+		simd_type M = Kokkos::max(I, D);
+		M = Kokkos::max(M, X);
+
+		wave_cur.data[ins * number_per_col + k - low] = I;
+		wave_cur.data[del * number_per_col + k - low] = D;
+		wave_cur.data[match * number_per_col + k - low] = M;
+	}
+}
+
+//Extends the match offsets of every lane that is still aligning
+static void extend(wfa::batch_wavefront_t& wavefront, const group_t& group) {
+	using namespace wfa;
+	int32_t number_per_col = wavefront.high - wavefront.low + 1;
+	std::array<int32_t, lanes> offsets;
+	for (int32_t row = 0; row < number_per_col; ++row) {
+		int32_t k = wavefront.low + row;
+		simd_type& M = wavefront.data[match * number_per_col + row];
+		M.copy_to(offsets.data(), tag_type());
+		for (int32_t lane = 0; lane < lanes; ++lane) {
+			if (not group.active[lane] or offsets[lane] == -1) {
+				continue;
+			}
+			int32_t h = offsets[lane];
+			offsets[lane] = h + match_length_simd(group.a[lane], h - k, group.b[lane], h);
+		}
+		M.copy_from(offsets.data(), tag_type());
+	}
+}
+
+//Aligns one group of lanes, writing the score of each lane that has a pair
+static void align_group(wfa::batch_arena_t& arena, group_t& group, int32_t x, int32_t o, int32_t e, std::span<int32_t> scores) {
+	using namespace wfa;
+	for (auto& wavefront : arena.ring) {
+		wavefront.score = -1;
+	}
+	batch_wavefront_t& first = slot(arena, 0);
+	first.score = 0;
+	first.valid = true;
+	first.low = 0;
+	first.high = 0;
+	first.data.resize(3);
+	first.data[ins] = simd_type(-1);
+	first.data[del] = simd_type(-1);
+	first.data[match] = simd_type(0);
+
+	int32_t remaining = static_cast<int32_t>(std::count(group.active.begin(), group.active.end(), true));
+	int32_t score = 0;
+	while (true) {
+		batch_wavefront_t& wavefront = slot(arena, score);
+		extend(wavefront, group);
+		int32_t number_per_col = wavefront.high - wavefront.low + 1;
+		for (int32_t lane = 0; lane < lanes; ++lane) {
+			if (not group.active[lane]) {
+				continue;
+			}
+			int32_t final_k = static_cast<int32_t>(group.b[lane].size()) - static_cast<int32_t>(group.a[lane].size());
+			if (final_k < wavefront.low or final_k > wavefront.high) {
+				continue;
+			}
+			if (wavefront.data[match * number_per_col + final_k - wavefront.low][lane] >= static_cast<int32_t>(group.b[lane].size())) {
+				scores[lane] = -1 * score;
+				group.active[lane] = false;
+				--remaining;
+			}
+		}
+		if (remaining == 0) {
+			break;
+		}
+
+		++score;
+		while (not (source(arena, score - x) or source(arena, score - o - e) or source(arena, score - e))) {
+			batch_wavefront_t& null_score = slot(arena, score);
+			null_score.score = score;
+			null_score.valid = false;
+			++score;
+		}
+		next(arena, score, x, o, e);
+	}
+}
+
+void wfa::wavefront_batch(std::span<const std::pair<std::string, std::string>> pairs, int32_t x, int32_t o, int32_t e, batch_arena_t& arena, std::span<int32_t> scores) {
+	size_t window = static_cast<size_t>(std::max(x, o + e));
+	if (arena.ring.size() < window + 1) {
+		arena.ring.resize(window + 1);
+	}
+	for (size_t first = 0; first < pairs.size(); first += lanes) {
+		size_t count = std::min(pairs.size() - first, static_cast<size_t>(lanes));
+		group_t group;
+		for (size_t lane = 0; lane < static_cast<size_t>(lanes); ++lane) {
+			group.active[lane] = lane < count;
+			group.a[lane] = lane < count ? std::string_view(pairs[first + lane].first) : std::string_view();
+			group.b[lane] = lane < count ? std::string_view(pairs[first + lane].second) : std::string_view();
+		}
+		align_group(arena, group, x, o, e, scores.subspan(first, count));
+	}
+}
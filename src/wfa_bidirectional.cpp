@@ -0,0 +1,246 @@
+#include "include/wfa_bidirectional.hpp"
+#include "include/wfa_simd.hpp"
+
+#include <algorithm>
+#include <limits>
+
+//Where the forward and reverse searches meet, in the coordinates of the forward search
+struct breakpoint_t {
+	int32_t score = std::numeric_limits<int32_t>::max();
+	int32_t score_forward = 0;
+	int32_t score_reverse = 0;
+	int32_t k = 0;
+	int32_t offset = 0;
+	int32_t column = wfa::match;
+};
+
+//A piece of the alignment, given as ranges of both sequences and the columns it has to begin and end in
+struct piece_t {
+	int32_t a_begin;
+	int32_t a_end;
+	int32_t b_begin;
+	int32_t b_end;
+	int32_t begin;
+	int32_t end;
+};
+
+struct bidirectional_t {
+	std::string_view a;
+	std::string_view b;
+	int32_t x;
+	int32_t o;
+	int32_t e;
+	//Number of scores back that next reads from, and so the number of wavefronts each search keeps
+	int32_t window;
+	wfa::bidirectional_arena_t& arena;
+};
+
+//Inserts the score 0 wavefront of a search that begins in the given column.
+//A forward search that begins in a gap continues one opened by the previous piece, but may also leave it straight away.
+//A reverse search that begins in a gap is the end of a piece that has to finish inside that gap
+static void start(wfa::wavefront_t& wavefront, int32_t column, bool reverse) {
+	auto& first = wavefront.insert(0, 0);
+	first.no_bound(wfa::ins, 0) = -1;
+	first.no_bound(wfa::del, 0) = -1;
+	first.no_bound(wfa::match, 0) = -1;
+	first.no_bound(column, 0) = 0;
+	if (not reverse) {
+		first.no_bound(wfa::match, 0) = 0;
+	}
+}
+
+//Advances a search to its next non-null score, dropping wavefronts that have left the window. Returns the new score
+static int32_t step(wfa::wavefront_t& wavefront, std::string_view a, std::string_view b, int32_t score, int32_t x, int32_t o, int32_t e, int32_t window) {
+	++score;
+	while (not (
+		wavefront.valid_score(score - x)
+		or wavefront.valid_score(score - o - e)
+		or wavefront.valid_score(score - e)
+		)) {
+		wavefront.insert();
+		++score;
+	}
+	wfa::next_simd(wavefront, score, x, o, e);
+	wfa::extend_simd(wavefront, a, b);
+	if (window > 0 and static_cast<int32_t>(wavefront.views.size()) > 2 * window) {
+		wavefront.compact(window);
+	}
+	return score;
+}
+
+//The furthest antidiagonal (v + h) reached by the newest wavefront of a search
+static int32_t furthest(wfa::wavefront_t& wavefront) {
+	wfa::wavefront_entry_t& entry = wavefront.views.back();
+	int32_t antidiagonal = -1;
+	for (int32_t k = entry.low; k < entry.high + 1; ++k) {
+		int32_t offset = entry.lookup(wfa::match, k);
+		if (offset != -1) {
+			antidiagonal = std::max(antidiagonal, 2 * offset - k);
+		}
+	}
+	return antidiagonal;
+}
+
+//Checks whether the forward and reverse offsets of one column overlap on a forward diagonal, and are both inside the piece
+static bool meets(int32_t k, int32_t forward, int32_t k_reverse, int32_t reverse, int32_t n, int32_t m) {
+	return forward != -1 and reverse != -1
+		and forward + reverse >= m
+		and forward <= m and forward - k <= n
+		and reverse <= m and reverse - k_reverse <= n;
+}
+
+//Compares the newest wavefront of one search against the wavefronts of the other search from score low to high, keeping the cheapest meeting point.
+//shift is added to every reverse score, see find_breakpoint
+static void overlap(wfa::wavefront_t& newest, int32_t score, wfa::wavefront_t& other, int32_t low, int32_t high, bool newest_is_forward, int32_t n, int32_t m, int32_t o, int32_t shift, breakpoint_t& breakpoint) {
+	using namespace wfa;
+	wavefront_entry_t& entry = newest.views.back();
+	for (int32_t other_score = high; other_score >= low; --other_score) {
+		if (not other.valid_score(other_score)) {
+			continue;
+		}
+		int32_t score_forward = newest_is_forward ? score : other_score;
+		int32_t score_reverse = newest_is_forward ? other_score : score;
+		int32_t total = score_forward + score_reverse + shift;
+		if (total - o >= breakpoint.score) {
+			continue;
+		}
+		for (int32_t k_newest = entry.low; k_newest < entry.high + 1; ++k_newest) {
+			//Diagonal k of the forward search is diagonal (m - n) - k of the reverse search
+			int32_t k_other = (m - n) - k_newest;
+			int32_t k_forward = newest_is_forward ? k_newest : k_other;
+			int32_t k_reverse = newest_is_forward ? k_other : k_newest;
+			for (int32_t column : { match, ins, del }) {
+				//Gaps that meet are one gap, which both searches paid to open
+				int32_t cost = column == match ? total : total - o;
+				if (cost >= breakpoint.score) {
+					continue;
+				}
+				int32_t newest_offset = entry.lookup(column, k_newest);
+				int32_t other_offset = other.lookup(other_score, column, k_other);
+				int32_t forward = newest_is_forward ? newest_offset : other_offset;
+				int32_t reverse = newest_is_forward ? other_offset : newest_offset;
+				if (meets(k_forward, forward, k_reverse, reverse, n, m)) {
+					breakpoint.score = cost;
+					breakpoint.score_forward = score_forward;
+					breakpoint.score_reverse = score_reverse;
+					breakpoint.k = k_forward;
+					breakpoint.offset = forward;
+					breakpoint.column = column;
+				}
+			}
+		}
+	}
+}
+
+//Runs both searches over a piece until no meeting point cheaper than the best one found can appear
+static breakpoint_t find_breakpoint(bidirectional_t& context, const piece_t& piece) {
+	using namespace wfa;
+	int32_t n = piece.a_end - piece.a_begin;
+	int32_t m = piece.b_end - piece.b_begin;
+	int32_t a_size = static_cast<int32_t>(context.a.size());
+	int32_t b_size = static_cast<int32_t>(context.b.size());
+	std::string_view a = context.a.substr(piece.a_begin, n);
+	std::string_view b = context.b.substr(piece.b_begin, m);
+	std::string_view a_reversed = std::string_view(context.arena.a_reversed).substr(a_size - piece.a_end, n);
+	std::string_view b_reversed = std::string_view(context.arena.b_reversed).substr(b_size - piece.b_end, m);
+	int32_t x = context.x;
+	int32_t o = context.o;
+	int32_t e = context.e;
+	int32_t window = context.window;
+	//A reverse search that begins in a gap does not pay to open it, though the piece has to, so its scores are o short
+	int32_t shift = piece.end == match ? 0 : o;
+
+	wavefront_t forward(context.arena.forward);
+	wavefront_t reverse(context.arena.reverse);
+	start(forward, piece.begin, false);
+	extend_simd(forward, a, b);
+	start(reverse, piece.end, true);
+	extend_simd(reverse, a_reversed, b_reversed);
+
+	breakpoint_t breakpoint;
+	int32_t score_forward = 0;
+	int32_t score_reverse = 0;
+	//The searches can only meet once the antidiagonals they reached add up to the length of the piece, so comparing wavefronts waits until then
+	int32_t furthest_forward = furthest(forward);
+	int32_t furthest_reverse = furthest(reverse);
+	overlap(forward, score_forward, reverse, 0, 0, true, n, m, o, shift, breakpoint);
+	while (true) {
+		score_forward = step(forward, a, b, score_forward, x, o, e, window);
+		furthest_forward = std::max(furthest_forward, furthest(forward));
+		int32_t low_reverse = std::max(score_reverse - window + 1, 0);
+		if (score_forward + low_reverse + shift - o >= breakpoint.score) {
+			break;
+		}
+		if (furthest_forward + furthest_reverse >= n + m) {
+			overlap(forward, score_forward, reverse, low_reverse, score_reverse, true, n, m, o, shift, breakpoint);
+		}
+
+		score_reverse = step(reverse, a_reversed, b_reversed, score_reverse, x, o, e, window);
+		furthest_reverse = std::max(furthest_reverse, furthest(reverse));
+		int32_t low_forward = std::max(score_forward - window + 1, 0);
+		if (low_forward + score_reverse + shift - o >= breakpoint.score) {
+			break;
+		}
+		if (furthest_forward + furthest_reverse >= n + m) {
+			overlap(reverse, score_reverse, forward, low_forward, score_forward, false, n, m, o, shift, breakpoint);
+		}
+	}
+
+	context.arena.forward.reset();
+	context.arena.reverse.reset();
+	return breakpoint;
+}
+
+//Aligns a piece with a single search that keeps every wavefront, and appends its cigar
+static void align_piece(bidirectional_t& context, const piece_t& piece, std::string& cigar) {
+	using namespace wfa;
+	int32_t n = piece.a_end - piece.a_begin;
+	int32_t m = piece.b_end - piece.b_begin;
+	std::string_view a = context.a.substr(piece.a_begin, n);
+	std::string_view b = context.b.substr(piece.b_begin, m);
+
+	wavefront_t wavefront(context.arena.forward);
+	start(wavefront, piece.begin, false);
+	extend_simd(wavefront, a, b);
+
+	int32_t score = 0;
+	int32_t final_k = m - n;
+	while (wavefront.views.back().lookup(piece.end, final_k) < m) {
+		score = step(wavefront, a, b, score, context.x, context.o, context.e, 0);
+	}
+	backtrace(wavefront, a, b, score, context.x, context.o, context.e, context.arena.piece, piece.begin, piece.end);
+	cigar.append(context.arena.piece);
+	context.arena.forward.reset();
+}
+
+//Aligns a piece by splitting it where both searches meet, and appends its cigar. Returns the score of the piece
+static int32_t align_bidirectional(bidirectional_t& context, const piece_t& piece, std::string& cigar) {
+	breakpoint_t breakpoint = find_breakpoint(context, piece);
+	//Splitting only makes progress while both searches moved past their first wavefront
+	if (breakpoint.score <= wfa::bidirectional_fallback_score or breakpoint.score_forward == 0 or breakpoint.score_reverse == 0) {
+		align_piece(context, piece, cigar);
+		return breakpoint.score;
+	}
+	int32_t v = piece.a_begin + breakpoint.offset - breakpoint.k;
+	int32_t h = piece.b_begin + breakpoint.offset;
+	align_bidirectional(context, { piece.a_begin, v, piece.b_begin, h, piece.begin, breakpoint.column }, cigar);
+	align_bidirectional(context, { v, piece.a_end, h, piece.b_end, breakpoint.column, piece.end }, cigar);
+	return breakpoint.score;
+}
+
+int32_t wfa::wavefront_bidirectional(std::string_view a, std::string_view b, int32_t x, int32_t o, int32_t e, bidirectional_arena_t& arena) {
+	arena.a_reversed.assign(a.rbegin(), a.rend());
+	arena.b_reversed.assign(b.rbegin(), b.rend());
+	bidirectional_t context{ a, b, x, o, e, std::max(x, o + e), arena };
+	piece_t whole{ 0, static_cast<int32_t>(a.size()), 0, static_cast<int32_t>(b.size()), match, match };
+	return -1 * find_breakpoint(context, whole).score;
+}
+
+int32_t wfa::wavefront_bidirectional(std::string_view a, std::string_view b, int32_t x, int32_t o, int32_t e, bidirectional_arena_t& arena, std::string& cigar) {
+	arena.a_reversed.assign(a.rbegin(), a.rend());
+	arena.b_reversed.assign(b.rbegin(), b.rend());
+	bidirectional_t context{ a, b, x, o, e, std::max(x, o + e), arena };
+	piece_t whole{ 0, static_cast<int32_t>(a.size()), 0, static_cast<int32_t>(b.size()), match, match };
+	cigar.clear();
+	return -1 * align_bidirectional(context, whole, cigar);
+}
@@ -0,0 +1,87 @@
+#include "include/wfa_ends_free.hpp"
+
+#include <algorithm>
+
+//Inserts the score 0 wavefront. Diagonal k >= 0 starts k bases into b and k < 0 starts -k bases into a, for every k a free begin covers
+static void start(wfa::wavefront_t& wavefront, int32_t n, int32_t m, const wfa::ends_free_t& ends) {
+	using namespace wfa;
+	int32_t low = -std::clamp(ends.a_begin, 0, n);
+	int32_t high = std::clamp(ends.b_begin, 0, m);
+	auto& first = wavefront.insert(low, high);
+	for (int32_t k = low; k < high + 1; ++k) {
+		first.no_bound(ins, k - low) = -1;
+		first.no_bound(del, k - low) = -1;
+		first.no_bound(match, k - low) = std::max(k, 0);
+	}
+}
+
+//Whether any diagonal of the newest, extended wavefront has reached the end of one sequence with no more than the free end of the other left
+static bool reached_end(wfa::wavefront_t& wavefront, int32_t n, int32_t m, const wfa::ends_free_t& ends) {
+	using namespace wfa;
+	wavefront_entry_t& entry = wavefront.newest();
+	const int32_t* offsets = entry.start_ptr(match);
+	for (int32_t k = entry.low; k < entry.high + 1; ++k) {
+		int32_t h = offsets[k - entry.low];
+		if (h == -1) {
+			continue;
+		}
+		int32_t v = h - k;
+		//Offsets that stepped past the end of a sequence are not alignments, a neighbouring diagonal already reached that end for less
+		if (h == m and v <= n and n - v <= ends.a_end) {
+			return true;
+		}
+		if (v == n and h <= m and m - h <= ends.b_end) {
+			return true;
+		}
+	}
+	return false;
+}
+
+template <bool simd>
+static int32_t align(wfa::wavefront_arena_t& arena, std::string_view a, std::string_view b, int32_t x, int32_t o, int32_t e, const wfa::ends_free_t& ends) {
+	using namespace wfa;
+	int32_t n = static_cast<int32_t>(a.size());
+	int32_t m = static_cast<int32_t>(b.size());
+	wavefront_t wavefront(arena);
+	wavefront.ring(std::max(x, o + e));
+	start(wavefront, n, m, ends);
+
+	int32_t score = 0;
+	while (true) {
+		if constexpr (simd) {
+			extend_simd(wavefront, a, b);
+		}
+		else {
+			extend(wavefront, a, b);
+		}
+		if (reached_end(wavefront, n, m, ends)) {
+			break;
+		}
+
+		++score;
+		while (not (
+			wavefront.valid_score(score - x)
+			or wavefront.valid_score(score - e - o)
+			or (wavefront.valid_score(score - e) and (score - e >= o))
+			)) {
+			wavefront.insert();
+			++score;
+		}
+		if constexpr (simd) {
+			next_simd(wavefront, score, x, o, e);
+		}
+		else {
+			next(wavefront, score, x, o, e);
+		}
+	}
+	arena.reset();
+	return -1 * score;
+}
+
+int32_t wfa::wavefront_ends_free(std::string_view a, std::string_view b, int32_t x, int32_t o, int32_t e, const ends_free_t& ends, wavefront_arena_t& arena) {
+	return align<false>(arena, a, b, x, o, e, ends);
+}
+
+int32_t wfa::wavefront_ends_free_simd(std::string_view a, std::string_view b, int32_t x, int32_t o, int32_t e, const ends_free_t& ends, wavefront_arena_t& arena) {
+	return align<true>(arena, a, b, x, o, e, ends);
+}
@@ -0,0 +1,137 @@
+#include "include/wfa_extension.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+
+//The score of the furthest offset of diagonal k in any column of the newest wavefront that is still inside both sequences, or the lowest int32_t if there is none.
+//An insertion or deletion can step past the end of a sequence and hide a gap that is still inside it, so the gap columns are scored too
+static int32_t score_of(wfa::wavefront_entry_t& entry, int32_t k, int32_t s, int32_t n, int32_t m, const wfa::drop_t& drop, int32_t& offset) {
+	offset = -1;
+	for (int32_t column : { wfa::match, wfa::ins, wfa::del }) {
+		int32_t h = entry.lookup(column, k);
+		int32_t v = h - k;
+		if (h != -1 and h <= m and v <= n and v >= 0) {
+			offset = std::max(offset, h);
+		}
+	}
+	if (offset == -1) {
+		return std::numeric_limits<int32_t>::min();
+	}
+	return drop.match * (2 * offset - k) - s;
+}
+
+//Moves best to the best diagonal of the newest, extended wavefront of score s if it beats it, then drops the diagonals that trail it by more than the threshold.
+//The wavefront is narrowed to the diagonals left, and dropped ones inside that range are cleared so next does not build on them. Returns whether any diagonal is left
+static bool drop_diagonals(wfa::wavefront_t& wavefront, int32_t s, int32_t n, int32_t m, int32_t e, const wfa::drop_t& drop, wfa::extension_t& best) {
+	using namespace wfa;
+	wavefront_entry_t& entry = wavefront.newest();
+	for (int32_t k = entry.low; k < entry.high + 1; ++k) {
+		int32_t h;
+		int32_t score = score_of(entry, k, s, n, m, drop, h);
+		if (score > best.score) {
+			best = { score, h - k, h };
+		}
+	}
+
+	int32_t best_k = best.b_length - best.a_length;
+	auto dropped = [&](int32_t k) {
+		int32_t h;
+		int32_t score = score_of(entry, k, s, n, m, drop, h);
+		if (score == std::numeric_limits<int32_t>::min()) {
+			return true;
+		}
+		int32_t threshold = drop.threshold;
+		if (drop.diagonal) {
+			threshold += e * std::abs(k - best_k);
+		}
+		return best.score - score > threshold;
+	};
+
+	int32_t low = entry.low;
+	while (low < entry.high + 1 and dropped(low)) {
+		++low;
+	}
+	if (low == entry.high + 1) {
+		//Nothing left, a single cleared diagonal keeps the wavefront valid for the recurrences
+		wavefront.shrink(entry.low, entry.low);
+		for (int32_t column = 0; column < wavefront.columns; ++column) {
+			entry.no_bound(column, 0) = -1;
+		}
+		return false;
+	}
+	int32_t high = entry.high;
+	while (dropped(high)) {
+		--high;
+	}
+	for (int32_t k = low + 1; k < high; ++k) {
+		if (dropped(k)) {
+			for (int32_t column = 0; column < wavefront.columns; ++column) {
+				entry.set(column, k, -1);
+			}
+		}
+	}
+	if (low != entry.low or high != entry.high) {
+		wavefront.shrink(low, high);
+	}
+	return true;
+}
+
+template <bool simd>
+static wfa::extension_t align(wfa::wavefront_arena_t& arena, std::string_view a, std::string_view b, int32_t x, int32_t o, int32_t e, const wfa::drop_t& drop) {
+	using namespace wfa;
+	int32_t n = static_cast<int32_t>(a.size());
+	int32_t m = static_cast<int32_t>(b.size());
+	int32_t window = std::max(x, o + e);
+	wavefront_t wavefront(arena);
+	wavefront.ring(window);
+	auto& first = wavefront.insert(0, 0);
+	first.no_bound(ins, 0) = -1;
+	first.no_bound(del, 0) = -1;
+	first.no_bound(match, 0) = 0;
+
+	extension_t best{ 0, 0, 0 };
+	//The last score with a diagonal left. Once the window has passed it, no later wavefront can have an offset
+	int32_t alive = 0;
+	int32_t score = 0;
+	while (true) {
+		if constexpr (simd) {
+			extend_simd(wavefront, a, b);
+		}
+		else {
+			extend(wavefront, a, b);
+		}
+		if (drop_diagonals(wavefront, score, n, m, e, drop, best)) {
+			alive = score;
+		}
+
+		++score;
+		while (not (
+			wavefront.valid_score(score - x)
+			or wavefront.valid_score(score - e - o)
+			or (wavefront.valid_score(score - e) and (score - e >= o))
+			)) {
+			wavefront.insert();
+			++score;
+		}
+		if (score - alive > window) {
+			break;
+		}
+		if constexpr (simd) {
+			next_simd(wavefront, score, x, o, e);
+		}
+		else {
+			next(wavefront, score, x, o, e);
+		}
+	}
+	arena.reset();
+	return best;
+}
+
+wfa::extension_t wfa::wavefront_extension(std::string_view a, std::string_view b, int32_t x, int32_t o, int32_t e, const drop_t& drop, wavefront_arena_t& arena) {
+	return align<false>(arena, a, b, x, o, e, drop);
+}
+
+wfa::extension_t wfa::wavefront_extension_simd(std::string_view a, std::string_view b, int32_t x, int32_t o, int32_t e, const drop_t& drop, wavefront_arena_t& arena) {
+	return align<true>(arena, a, b, x, o, e, drop);
+}
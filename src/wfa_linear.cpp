@@ -0,0 +1,165 @@
+#include "include/wfa_linear.hpp"
+
+#include <algorithm>
+#include <limits>
+
+//The wavefront with the given score, or null if there is none
+static wfa::wavefront_entry_t* source(wfa::wavefront_t& wavefront, int32_t score) {
+	int32_t index = wavefront.index(score);
+	return index == -1 ? nullptr : &wavefront.views[index];
+}
+
+//The furthest offset of diagonal k from the mismatch and gap source wavefronts, either of which may be null
+static int32_t furthest(wfa::wavefront_entry_t* mismatch, wfa::wavefront_entry_t* gap, int32_t k) {
+	int32_t offset = -1;
+	if (mismatch != nullptr) {
+		int32_t X = mismatch->lookup(0, k);
+		if (X != -1) {
+			offset = X + 1;
+		}
+	}
+	if (gap != nullptr) {
+		int32_t I = gap->lookup(0, k - 1);
+		if (I != -1) {
+			offset = std::max(offset, I + 1);
+		}
+		offset = std::max(offset, gap->lookup(0, k + 1));
+	}
+	return offset;
+}
+
+//Inserts the wavefront of score s, spanning every diagonal its sources reach, and returns it along with those sources
+template <typename penalty_t>
+static wfa::wavefront_entry_t& insert(wfa::wavefront_t& wavefront, int32_t s, const penalty_t& p, wfa::wavefront_entry_t*& mismatch, wfa::wavefront_entry_t*& gap) {
+	int32_t high = std::numeric_limits<int32_t>::min();
+	int32_t low = std::numeric_limits<int32_t>::max();
+	if (wavefront.valid_score(s - p.x)) {
+		high = std::max(high, wavefront.wave_size_high(s - p.x));
+		low = std::min(low, wavefront.wave_size_low(s - p.x));
+	}
+	if (wavefront.valid_score(s - p.e)) {
+		high = std::max(high, wavefront.wave_size_high(s - p.e) + 1);
+		low = std::min(low, wavefront.wave_size_low(s - p.e) - 1);
+	}
+	wfa::wavefront_entry_t& wave_cur = wavefront.insert(low, high);
+	//Only looked up now, as inserting into a ring can move the other wavefronts
+	mismatch = source(wavefront, s - p.x);
+	gap = source(wavefront, s - p.e);
+	return wave_cur;
+}
+
+template <typename penalty_t>
+static void next_step(wfa::wavefront_t& wavefront, int32_t s, const penalty_t& p) {
+	wfa::wavefront_entry_t* mismatch;
+	wfa::wavefront_entry_t* gap;
+	wfa::wavefront_entry_t& wave_cur = insert(wavefront, s, p, mismatch, gap);
+	int32_t* offsets = wave_cur.start_ptr(0);
+	for (int32_t k = wave_cur.low; k < wave_cur.high + 1; ++k) {
+		offsets[k - wave_cur.low] = furthest(mismatch, gap, k);
+	}
+}
+
+template <typename penalty_t>
+static void next_simd_step(wfa::wavefront_t& wavefront, int32_t s, const penalty_t& p) {
+	using namespace wfa;
+	wavefront_entry_t* mismatch;
+	wavefront_entry_t* gap;
+	wavefront_entry_t& wave_cur = insert(wavefront, s, p, mismatch, gap);
+	int32_t* offsets = wave_cur.start_ptr(0);
+	int32_t low = wave_cur.low;
+	int32_t high = wave_cur.high;
+
+	constexpr int32_t simd_size = static_cast<int32_t>(simd_type::size());
+
+	int32_t k = low;
+	while (high - k + 1 > simd_size) {
+		simd_type X = mismatch != nullptr ? simd_lookup(*mismatch, 0, k, 0) : simd_type(-1);
+		Kokkos::Experimental::where(X != -1, X) = X + 1;
+
+		simd_type I = gap != nullptr ? simd_lookup(*gap, 0, k, -1) : simd_type(-1);
+		Kokkos::Experimental::where(I != -1, I) = I + 1;
+
+		simd_type D = gap != nullptr ? simd_lookup(*gap, 0, k, +1) : simd_type(-1);
+
+		simd_type M = Kokkos::max(Kokkos::max(X, I), D);
+		M.copy_to(offsets + (k - low), tag_type());
+
+		k += simd_size;
+	}
+
+	for (; k < high + 1; ++k) {
+		offsets[k - low] = furthest(mismatch, gap, k);
+	}
+}
+
+void wfa::next_linear(wavefront_t& wavefront, int32_t s, int32_t x, int32_t e) {
+	next_step(wavefront, s, penalties_t{ x, 0, e });
+}
+
+void wfa::next_linear_simd(wavefront_t& wavefront, int32_t s, int32_t x, int32_t e) {
+	next_simd_step(wavefront, s, penalties_t{ x, 0, e });
+}
+
+//Runs the alignment in a ring of single column wavefronts. penalty_t is wfa::penalties_t or a wfa::fixed_penalties_t, of which only x and e are used
+template <bool simd, typename penalty_t>
+static int32_t align(wfa::wavefront_arena_t& arena, std::string_view a, std::string_view b, const penalty_t& p) {
+	using namespace wfa;
+	wavefront_t wavefront(arena, 1);
+	wavefront.ring(std::max(p.x, p.e));
+	auto& first = wavefront.insert(0, 0);
+	first.no_bound(0, 0) = 0;
+
+	int32_t score = 0;
+	int32_t final_k = static_cast<int32_t>(b.size()) - static_cast<int32_t>(a.size());
+	int32_t final_offset = static_cast<int32_t>(b.size());
+
+	while (true) {
+		wavefront_entry_t& entry = wavefront.newest();
+		int32_t* offsets = entry.start_ptr(0);
+		for (int32_t k = entry.low; k < entry.high + 1; ++k) {
+			int32_t offset = offsets[k - entry.low];
+			if (offset == -1) {
+				continue;
+			}
+			if constexpr (simd) {
+				offsets[k - entry.low] = offset + match_length_simd(a, offset - k, b, offset);
+			}
+			else {
+				offsets[k - entry.low] = offset + match_length(a, offset - k, b, offset);
+			}
+		}
+		if (entry.lookup(0, final_k) >= final_offset) {
+			break;
+		}
+
+		++score;
+		while (not (wavefront.valid_score(score - p.x) or wavefront.valid_score(score - p.e))) {
+			wavefront.insert();
+			++score;
+		}
+		if constexpr (simd) {
+			next_simd_step(wavefront, score, p);
+		}
+		else {
+			next_step(wavefront, score, p);
+		}
+	}
+	arena.reset();
+	return -1 * score;
+}
+
+int32_t wfa::wavefront_linear(std::string_view a, std::string_view b, int32_t x, int32_t e, wavefront_arena_t& arena) {
+	return align<false>(arena, a, b, penalties_t{ x, 0, e });
+}
+
+int32_t wfa::wavefront_linear_simd(std::string_view a, std::string_view b, int32_t x, int32_t e, wavefront_arena_t& arena) {
+	return align<true>(arena, a, b, penalties_t{ x, 0, e });
+}
+
+int32_t wfa::wavefront_edit(std::string_view a, std::string_view b, wavefront_arena_t& arena) {
+	return align<false>(arena, a, b, fixed_penalties_t<1, 0, 1>{});
+}
+
+int32_t wfa::wavefront_edit_simd(std::string_view a, std::string_view b, wavefront_arena_t& arena) {
+	return align<true>(arena, a, b, fixed_penalties_t<1, 0, 1>{});
+}
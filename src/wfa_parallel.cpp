@@ -0,0 +1,71 @@
+#include "include/wfa_parallel.hpp"
+#include "include/wfa_simd.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+
+//The pairs a worker has not handed out yet. Aligned to a cache line so workers claiming from their own share do not contend
+struct alignas(64) share_t {
+	std::atomic<size_t> next;
+	size_t end;
+};
+
+//Claims the next chunk of a share, returning false once it is empty. Owners and thieves claim the same way, so every pair is handed out exactly once
+static bool claim(share_t& share, size_t chunk, size_t& first, size_t& last) {
+	if (share.next.load(std::memory_order_relaxed) >= share.end) {
+		return false;
+	}
+	first = share.next.fetch_add(chunk, std::memory_order_relaxed);
+	if (first >= share.end) {
+		return false;
+	}
+	last = std::min(first + chunk, share.end);
+	return true;
+}
+
+static void work(std::span<const std::pair<std::string, std::string>> pairs, int32_t x, int32_t o, int32_t e, wfa::wavefront_arena_t& arena, std::span<int32_t> scores, std::span<share_t> shares, size_t worker, size_t chunk) {
+	size_t first = 0;
+	size_t last = 0;
+	//Own share first, then the others in order starting from the next worker, so thieves spread out over the victims
+	for (size_t i = 0; i < shares.size(); ++i) {
+		share_t& share = shares[(worker + i) % shares.size()];
+		while (claim(share, chunk, first, last)) {
+			for (size_t pair = first; pair < last; ++pair) {
+				scores[pair] = wfa::wavefront_simd(pairs[pair].first, pairs[pair].second, x, o, e, arena);
+			}
+		}
+	}
+}
+
+void wfa::wavefront_parallel(std::span<const std::pair<std::string, std::string>> pairs, int32_t x, int32_t o, int32_t e, parallel_arena_t& arena, std::span<int32_t> scores, int32_t threads) {
+	size_t workers = threads > 0 ? static_cast<size_t>(threads) : std::max(std::thread::hardware_concurrency(), 1u);
+	workers = std::max<size_t>(std::min(workers, pairs.size()), 1);
+	if (arena.arenas.size() < workers) {
+		arena.arenas.resize(workers);
+	}
+
+	//Small enough that stealing can even out the tail, large enough that claiming stays cheap next to aligning
+	size_t chunk = std::clamp<size_t>(pairs.size() / (workers * 16), 1, 64);
+	std::unique_ptr<share_t[]> shares(new share_t[workers]);
+	size_t per_worker = pairs.size() / workers;
+	size_t extra = pairs.size() % workers;
+	size_t begin = 0;
+	for (size_t worker = 0; worker < workers; ++worker) {
+		size_t size = per_worker + (worker < extra ? 1 : 0);
+		shares[worker].next.store(begin, std::memory_order_relaxed);
+		shares[worker].end = begin + size;
+		begin += size;
+	}
+
+	std::span<share_t> all_shares(shares.get(), workers);
+	{
+		std::vector<std::jthread> pool;
+		pool.reserve(workers - 1);
+		for (size_t worker = 1; worker < workers; ++worker) {
+			pool.emplace_back(work, pairs, x, o, e, std::ref(arena.arenas[worker]), scores, all_shares, worker, chunk);
+		}
+		work(pairs, x, o, e, arena.arenas[0], scores, all_shares, 0, chunk);
+	}
+}
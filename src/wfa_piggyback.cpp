@@ -0,0 +1,312 @@
+#include "include/wfa_piggyback.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+
+//An offset of a source wavefront with the operations that led to it
+struct source_t {
+	wfa::simd_type offset;
+	wfa::simd_type ops;
+	wfa::simd_type prev;
+};
+
+//Loads a run of offsets and their operations from the wavefront of the given score, or -1 if there is none
+static source_t load(wfa::wavefront_t& wavefront, int32_t score, int32_t column, int32_t k, int32_t scaling) {
+	using namespace wfa;
+	if (not wavefront.valid_score(score)) {
+		return { simd_type(-1), simd_type(-1), simd_type(-1) };
+	}
+	auto& entry = wavefront.views[wavefront.index(score)];
+	return {
+		simd_lookup(entry, column, k, scaling),
+		simd_lookup(entry, piggyback_ops + column, k, scaling),
+		simd_lookup(entry, piggyback_prev + column, k, scaling)
+	};
+}
+
+//Sets the operations of one offset to those of its source, with op packed on
+static void inherit(wfa::wavefront_entry_t& target, int32_t column, int32_t row, wfa::wavefront_t& wavefront, int32_t score, int32_t source_column, int32_t k, int32_t op) {
+	using namespace wfa;
+	target.no_bound(piggyback_ops + column, row) = (wavefront.lookup(score, piggyback_ops + source_column, k) << 2) + op;
+	target.no_bound(piggyback_prev + column, row) = wavefront.lookup(score, piggyback_prev + source_column, k);
+}
+
+//Computes diagonal k of the newest wavefront. Ties go to extending a gap, then to the gaps over a mismatch
+static void next_cell(wfa::wavefront_t& wavefront, wfa::wavefront_entry_t& wave_cur, int32_t s, int32_t x, int32_t o, int32_t e, int32_t k) {
+	using namespace wfa;
+	int32_t row = k - wave_cur.low;
+
+	int32_t open = wavefront.lookup(s - o - e, match, k - 1);
+	int32_t extend = wavefront.lookup(s - e, ins, k - 1);
+	if (open > extend) {
+		inherit(wave_cur, ins, row, wavefront, s - o - e, match, k - 1, op_insertion);
+	}
+	else {
+		inherit(wave_cur, ins, row, wavefront, s - e, ins, k - 1, op_extend);
+	}
+	int32_t insertion = std::max(open, extend);
+	if (insertion != -1) {
+		++insertion;
+	}
+	wave_cur.no_bound(ins, row) = insertion;
+
+	open = wavefront.lookup(s - o - e, match, k + 1);
+	extend = wavefront.lookup(s - e, del, k + 1);
+	if (open > extend) {
+		inherit(wave_cur, del, row, wavefront, s - o - e, match, k + 1, op_deletion);
+	}
+	else {
+		inherit(wave_cur, del, row, wavefront, s - e, del, k + 1, op_extend);
+	}
+	int32_t deletion = std::max(open, extend);
+	wave_cur.no_bound(del, row) = deletion;
+
+	int32_t mismatch = wavefront.lookup(s - x, match, k);
+	if (mismatch != -1) {
+		++mismatch;
+	}
+	int32_t best = std::max({ insertion, deletion, mismatch });
+	wave_cur.no_bound(match, row) = best;
+	if (best == insertion or best == deletion) {
+		int32_t column = best == insertion ? ins : del;
+		wave_cur.no_bound(piggyback_ops + match, row) = wave_cur.no_bound(piggyback_ops + column, row);
+		wave_cur.no_bound(piggyback_prev + match, row) = wave_cur.no_bound(piggyback_prev + column, row);
+	}
+	else {
+		inherit(wave_cur, match, row, wavefront, s - x, match, k, op_mismatch);
+	}
+}
+
+//Inserts the wavefront of score s, spanning the diagonals reachable from the source wavefronts that exist
+static wfa::wavefront_entry_t& insert_next(wfa::wavefront_t& wavefront, int32_t s, int32_t x, int32_t o, int32_t e) {
+	int32_t high = std::numeric_limits<int32_t>::min();
+	int32_t low = std::numeric_limits<int32_t>::max();
+	if (wavefront.valid_score(s - x)) {
+		high = std::max(high, wavefront.wave_size_high(s - x));
+		low = std::min(low, wavefront.wave_size_low(s - x));
+	}
+	if (wavefront.valid_score(s - o - e)) {
+		high = std::max(high, wavefront.wave_size_high(s - o - e) + 1);
+		low = std::min(low, wavefront.wave_size_low(s - o - e) - 1);
+	}
+	if (wavefront.valid_score(s - e)) {
+		high = std::max(high, wavefront.wave_size_high(s - e) + 1);
+		low = std::min(low, wavefront.wave_size_low(s - e) - 1);
+	}
+	return wavefront.insert(low, high);
+}
+
+void wfa::next_piggyback(wavefront_t& wavefront, int32_t s, int32_t x, int32_t o, int32_t e) {
+	auto& wave_cur = insert_next(wavefront, s, x, o, e);
+	for (int32_t k = wave_cur.low; k < wave_cur.high + 1; ++k) {
+		next_cell(wavefront, wave_cur, s, x, o, e, k);
+	}
+}
+
+void wfa::next_simd_piggyback(wavefront_t& wavefront, int32_t s, int32_t x, int32_t o, int32_t e) {
+	auto& wave_cur = insert_next(wavefront, s, x, o, e);
+	int32_t low = wave_cur.low;
+	int32_t high = wave_cur.high;
+
+	constexpr int32_t simd_size = static_cast<int32_t>(simd_type::size());
+
+	int32_t k = low;
+	while (high - k + 1 > simd_size) {
+		source_t M_soe_down = load(wavefront, s - o - e, match, k, -1);
+		source_t M_soe_up = load(wavefront, s - o - e, match, k, +1);
+		source_t I_se_down = load(wavefront, s - e, ins, k, -1);
+		source_t D_se_up = load(wavefront, s - e, del, k, +1);
+		source_t M_sx = load(wavefront, s - x, match, k, 0);
+
+		//The same comparisons as the max calls in next_simd, kept to pick the operations of the winning source
+		simd_type I = Kokkos::max(M_soe_down.offset, I_se_down.offset);
+		auto I_open = M_soe_down.offset > I_se_down.offset;
+		simd_type I_ops = I_se_down.ops << 2;
+		simd_type I_prev = I_se_down.prev;
+		Kokkos::Experimental::where(I_open, I_ops) = (M_soe_down.ops << 2) + op_insertion;
+		Kokkos::Experimental::where(I_open, I_prev) = M_soe_down.prev;
+		Kokkos::Experimental::where(I != -1, I) = I + 1;
+
+		simd_type D = Kokkos::max(M_soe_up.offset, D_se_up.offset);
+		auto D_open = M_soe_up.offset > D_se_up.offset;
+		simd_type D_ops = D_se_up.ops << 2;
+		simd_type D_prev = D_se_up.prev;
+		Kokkos::Experimental::where(D_open, D_ops) = (M_soe_up.ops << 2) + op_deletion;
+		Kokkos::Experimental::where(D_open, D_prev) = M_soe_up.prev;
+
+		Kokkos::Experimental::where(M_sx.offset != -1, M_sx.offset) = M_sx.offset + 1;
+		simd_type M = Kokkos::max(I, D);
+		M = Kokkos::max(M, M_sx.offset);
+		simd_type M_ops = (M_sx.ops << 2) + op_mismatch;
+		simd_type M_prev = M_sx.prev;
+		Kokkos::Experimental::where(M == D, M_ops) = D_ops;
+		Kokkos::Experimental::where(M == D, M_prev) = D_prev;
+		Kokkos::Experimental::where(M == I, M_ops) = I_ops;
+		Kokkos::Experimental::where(M == I, M_prev) = I_prev;
+
+		I.copy_to(wave_cur.start_ptr(ins) + (k - low), tag_type());
+		D.copy_to(wave_cur.start_ptr(del) + (k - low), tag_type());
+		M.copy_to(wave_cur.start_ptr(match) + (k - low), tag_type());
+		I_ops.copy_to(wave_cur.start_ptr(piggyback_ops + ins) + (k - low), tag_type());
+		D_ops.copy_to(wave_cur.start_ptr(piggyback_ops + del) + (k - low), tag_type());
+		M_ops.copy_to(wave_cur.start_ptr(piggyback_ops + match) + (k - low), tag_type());
+		I_prev.copy_to(wave_cur.start_ptr(piggyback_prev + ins) + (k - low), tag_type());
+		D_prev.copy_to(wave_cur.start_ptr(piggyback_prev + del) + (k - low), tag_type());
+		M_prev.copy_to(wave_cur.start_ptr(piggyback_prev + match) + (k - low), tag_type());
+
+		k += simd_size;
+	}
+
+	for (; k < high + 1; ++k) {
+		next_cell(wavefront, wave_cur, s, x, o, e, k);
+	}
+}
+
+void wfa::offload(wavefront_t& wavefront, std::vector<backtrace_block_t>& blocks) {
+	wavefront_entry_t& entry = wavefront.views.back();
+	for (int32_t row = 0; row < entry.number_per_col; ++row) {
+		//Match usually shares its operations with the gap it came from, which then only needs one block
+		int32_t shared = -1;
+		for (int32_t column : { ins, del }) {
+			if (entry.no_bound(column, row) != -1
+				and entry.no_bound(piggyback_ops + match, row) == entry.no_bound(piggyback_ops + column, row)
+				and entry.no_bound(piggyback_prev + match, row) == entry.no_bound(piggyback_prev + column, row)) {
+				shared = column;
+			}
+		}
+		for (int32_t column : { ins, del, match }) {
+			int32_t& ops = entry.no_bound(piggyback_ops + column, row);
+			int32_t& prev = entry.no_bound(piggyback_prev + column, row);
+			if (column == match and shared != -1) {
+				ops = entry.no_bound(piggyback_ops + shared, row);
+				prev = entry.no_bound(piggyback_prev + shared, row);
+				continue;
+			}
+			//The sentinel reaches the top bits after 15 operations
+			if (entry.no_bound(column, row) != -1 and (ops >> 30) != 0) {
+				blocks.push_back({ ops, prev });
+				ops = 1;
+				prev = static_cast<int32_t>(blocks.size()) - 1;
+			}
+		}
+	}
+}
+
+using next_kernel_t = void (*)(wfa::wavefront_t&, int32_t, int32_t, int32_t, int32_t);
+using extend_kernel_t = bool (*)(wfa::wavefront_t&, std::string_view, std::string_view);
+
+static int32_t align_piggyback(wfa::wavefront_t& wavefront, std::string_view a, std::string_view b, int32_t x, int32_t o, int32_t e, std::vector<wfa::backtrace_block_t>& blocks, next_kernel_t next_kernel, extend_kernel_t extend_kernel) {
+	using namespace wfa;
+	auto& first = wavefront.insert(0, 0);
+	first.no_bound(ins, 0) = -1;
+	first.no_bound(del, 0) = -1;
+	first.no_bound(match, 0) = 0;
+	for (int32_t column : { ins, del, match }) {
+		first.no_bound(piggyback_ops + column, 0) = 1;
+		first.no_bound(piggyback_prev + column, 0) = -1;
+	}
+
+	//Number of scores back that next reads from
+	int32_t window = std::max(x, o + e);
+	int32_t score = 0;
+
+	int32_t final_k = static_cast<int32_t>(b.size()) - static_cast<int32_t>(a.size());
+	int32_t final_offset = static_cast<int32_t>(b.size());
+
+	while (true) {
+		extend_kernel(wavefront, a, b);
+		if (wavefront.views.back().lookup(match, final_k) >= final_offset) {
+			break;
+		}
+		score = score + 1;
+		while (not (
+			wavefront.valid_score(score - x)
+			or wavefront.valid_score(score - e - o)
+			or (wavefront.valid_score(score - e) and (score - e >= o))
+		)) {
+			wavefront.insert();
+			++score;
+		}
+		next_kernel(wavefront, score, x, o, e);
+		offload(wavefront, blocks);
+		if (static_cast<int32_t>(wavefront.views.size()) > 2 * window) {
+			wavefront.compact(window);
+		}
+	}
+	return score;
+}
+
+//Unpacks the operations that led to the end of the alignment, finding the matches between them again
+static void rebuild(wfa::wavefront_t& wavefront, std::string_view a, std::string_view b, wfa::piggyback_arena_t& arena, std::string& cigar) {
+	using namespace wfa;
+	int32_t n = static_cast<int32_t>(a.size());
+	int32_t m = static_cast<int32_t>(b.size());
+	wavefront_entry_t& last = wavefront.views.back();
+
+	arena.chain.clear();
+	arena.chain.push_back(last.lookup(piggyback_ops + match, m - n));
+	for (int32_t block = last.lookup(piggyback_prev + match, m - n); block != -1; block = arena.blocks[block].prev) {
+		arena.chain.push_back(arena.blocks[block].ops);
+	}
+
+	cigar.clear();
+	int32_t v = 0;
+	int32_t h = 0;
+	char gap = 'M';
+	auto matches = [&]() {
+		while (v < n and h < m and a[v] == b[h]) {
+			cigar.push_back('M');
+			++v;
+			++h;
+		}
+	};
+	for (auto it = arena.chain.rbegin(); it != arena.chain.rend(); ++it) {
+		uint32_t ops = static_cast<uint32_t>(*it);
+		int32_t count = (31 - std::countl_zero(ops)) / 2;
+		for (int32_t i = count - 1; i >= 0; --i) {
+			int32_t op = (ops >> (2 * i)) & 3;
+			if (op != op_extend) {
+				matches();
+			}
+			if (op == op_mismatch) {
+				cigar.push_back('X');
+				++v;
+				++h;
+				continue;
+			}
+			if (op == op_insertion) {
+				gap = 'I';
+			}
+			else if (op == op_deletion) {
+				gap = 'D';
+			}
+			cigar.push_back(gap);
+			if (gap == 'I') {
+				++h;
+			}
+			else {
+				++v;
+			}
+		}
+	}
+	matches();
+}
+
+int32_t wfa::wavefront_piggyback(std::string_view a, std::string_view b, int32_t x, int32_t o, int32_t e, piggyback_arena_t& arena, std::string& cigar) {
+	wavefront_t wavefront(arena.wavefronts, piggyback_columns);
+	int32_t score = align_piggyback(wavefront, a, b, x, o, e, arena.blocks, next_piggyback, extend);
+	rebuild(wavefront, a, b, arena, cigar);
+	arena.wavefronts.reset();
+	arena.blocks.clear();
+	return -1 * score;
+}
+
+int32_t wfa::wavefront_simd_piggyback(std::string_view a, std::string_view b, int32_t x, int32_t o, int32_t e, piggyback_arena_t& arena, std::string& cigar) {
+	wavefront_t wavefront(arena.wavefronts, piggyback_columns);
+	int32_t score = align_piggyback(wavefront, a, b, x, o, e, arena.blocks, next_simd_piggyback, extend_simd);
+	rebuild(wavefront, a, b, arena, cigar);
+	arena.wavefronts.reset();
+	arena.blocks.clear();
+	return -1 * score;
+}
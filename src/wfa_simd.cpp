@@ -1,87 +1,296 @@
 #include "include/wfa_simd.hpp"
+#include "include/wfa_stats.hpp"
 
 #include "fmt/format.h"
 #include "fmt/ranges.h"
+#include <bit>
+#include <limits>
 
+#include <atomic>
+#include <cstdlib>
 
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define WFA_SIMD_DISPATCH
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+//GCC and Clang only allow the intrinsics of an instruction set in functions that target it. MSVC allows them anywhere
+#if defined(__GNUC__) || defined(__clang__)
+#define WFA_TARGET(isa) __attribute__((target(isa)))
+#else
+#define WFA_TARGET(isa)
+#endif
+
+//Each kernel compares a whole register of bytes, turns the result into a bitmask with one bit per byte, and finds the first mismatch with a count of trailing zeros.
+//On x86 every kernel is compiled whatever the build targets, and the widest one the CPU supports is picked at startup, see wfa::simd_level. Elsewhere only the 64-bit word kernel exists
+static int32_t match_length_scalar(const char* a, const char* b, int32_t limit) {
+	WFA_STAT(wfa::thread_stats().tail_characters += limit;)
+	return wfa::match_length_words(a, b, 0, limit);
+}
+
+#ifdef WFA_SIMD_DISPATCH
+WFA_TARGET("avx512bw") static int32_t match_length_avx512bw(const char* a, const char* b, int32_t limit) {
+	WFA_STAT(wfa::stats_t& stats = wfa::thread_stats();)
+	int32_t i = 0;
+	for (; i + 64 <= limit; i += 64) {
+		WFA_STAT(stats.vector_characters += 64;)
+		__m512i bytes_a = _mm512_loadu_si512(a + i);
+		__m512i bytes_b = _mm512_loadu_si512(b + i);
+		uint64_t mismatches = _mm512_cmpneq_epi8_mask(bytes_a, bytes_b);
+		if (mismatches != 0) {
+			return i + std::countr_zero(mismatches);
+		}
+	}
+	if (i == limit) {
+		return limit;
+	}
+	WFA_STAT(stats.tail_characters += limit - i;)
+	//Masked loads leave the bytes past the end untouched, so the tail takes the same path as the body
+	__mmask64 tail = (uint64_t(1) << (limit - i)) - 1;
+	__m512i bytes_a = _mm512_maskz_loadu_epi8(tail, a + i);
+	__m512i bytes_b = _mm512_maskz_loadu_epi8(tail, b + i);
+	uint64_t mismatches = _mm512_mask_cmpneq_epi8_mask(tail, bytes_a, bytes_b);
+	return mismatches != 0 ? i + std::countr_zero(mismatches) : limit;
+}
+
+WFA_TARGET("avx2") static uint32_t mismatch_mask_avx2(const char* a, const char* b) {
+	__m256i bytes_a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a));
+	__m256i bytes_b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b));
+	return ~static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes_a, bytes_b)));
+}
+
+WFA_TARGET("avx2") static int32_t match_length_avx2(const char* a, const char* b, int32_t limit) {
+	WFA_STAT(wfa::stats_t& stats = wfa::thread_stats();)
+	int32_t i = 0;
+	for (; i + 32 <= limit; i += 32) {
+		WFA_STAT(stats.vector_characters += 32;)
+		uint32_t mismatches = mismatch_mask_avx2(a + i, b + i);
+		if (mismatches != 0) {
+			return i + std::countr_zero(mismatches);
+		}
+	}
+	if (i == limit) {
+		return limit;
+	}
+	WFA_STAT(stats.tail_characters += limit - i;)
+	if (limit >= 32) {
+		//Compare the last register of the run again. The bytes before i are known to match, so the first mismatch is past them
+		int32_t last = limit - 32;
+		uint32_t mismatches = mismatch_mask_avx2(a + last, b + last);
+		return mismatches != 0 ? last + std::countr_zero(mismatches) : limit;
+	}
+	return wfa::match_length_words(a, b, i, limit);
+}
+
+WFA_TARGET("sse2") static uint32_t mismatch_mask_sse2(const char* a, const char* b) {
+	__m128i bytes_a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a));
+	__m128i bytes_b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b));
+	return ~static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes_a, bytes_b))) & 0xFFFF;
+}
+
+WFA_TARGET("sse2") static int32_t match_length_sse2(const char* a, const char* b, int32_t limit) {
+	WFA_STAT(wfa::stats_t& stats = wfa::thread_stats();)
+	int32_t i = 0;
+	for (; i + 16 <= limit; i += 16) {
+		WFA_STAT(stats.vector_characters += 16;)
+		uint32_t mismatches = mismatch_mask_sse2(a + i, b + i);
+		if (mismatches != 0) {
+			return i + std::countr_zero(mismatches);
+		}
+	}
+	if (i == limit) {
+		return limit;
+	}
+	WFA_STAT(stats.tail_characters += limit - i;)
+	if (limit >= 16) {
+		int32_t last = limit - 16;
+		uint32_t mismatches = mismatch_mask_sse2(a + last, b + last);
+		return mismatches != 0 ? last + std::countr_zero(mismatches) : limit;
+	}
+	return wfa::match_length_words(a, b, i, limit);
+}
+
+struct cpuid_t {
+	uint32_t eax, ebx, ecx, edx;
+};
+
+static cpuid_t cpuid(uint32_t leaf, uint32_t subleaf) {
+	cpuid_t registers{};
+#ifdef _MSC_VER
+	int values[4];
+	__cpuidex(values, static_cast<int>(leaf), static_cast<int>(subleaf));
+	registers = { static_cast<uint32_t>(values[0]), static_cast<uint32_t>(values[1]), static_cast<uint32_t>(values[2]), static_cast<uint32_t>(values[3]) };
+#else
+	__cpuid_count(leaf, subleaf, registers.eax, registers.ebx, registers.ecx, registers.edx);
+#endif
+	return registers;
+}
+
+//The register state the operating system saves on a context switch. AVX needs it to save the ymm registers, and AVX-512 the zmm and mask registers as well
+static uint64_t enabled_state() {
+#ifdef _MSC_VER
+	return _xgetbv(0);
+#else
+	uint32_t low, high;
+	__asm__ volatile("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+	return (static_cast<uint64_t>(high) << 32) | low;
+#endif
+}
+#endif
+
+wfa::simd_level_t wfa::detect_simd_level() {
+#ifdef WFA_SIMD_DISPATCH
+	uint32_t max_leaf = cpuid(0, 0).eax;
+	cpuid_t features = cpuid(1, 0);
+	if ((features.edx & (1u << 26)) == 0) {
+		return simd_level_t::scalar;
+	}
+	bool osxsave = (features.ecx & (1u << 27)) != 0;
+	bool avx = (features.ecx & (1u << 28)) != 0;
+	if (max_leaf < 7 or not osxsave or not avx) {
+		return simd_level_t::sse2;
+	}
+	uint64_t state = enabled_state();
+	cpuid_t extended = cpuid(7, 0);
+	bool avx512 = (extended.ebx & (1u << 16)) != 0 and (extended.ebx & (1u << 30)) != 0;
+	if (avx512 and (state & 0xE6) == 0xE6) {
+		return simd_level_t::avx512bw;
+	}
+	bool avx2 = (extended.ebx & (1u << 5)) != 0;
+	if (avx2 and (state & 0x6) == 0x6) {
+		return simd_level_t::avx2;
+	}
+	return simd_level_t::sse2;
+#else
+	return simd_level_t::scalar;
+#endif
+}
+
+using match_kernel_t = int32_t(*)(const char*, const char*, int32_t);
+
+static match_kernel_t kernel_for(wfa::simd_level_t level) {
+#ifdef WFA_SIMD_DISPATCH
+	switch (level) {
+	case wfa::simd_level_t::avx512bw:
+		return match_length_avx512bw;
+	case wfa::simd_level_t::avx2:
+		return match_length_avx2;
+	case wfa::simd_level_t::sse2:
+		return match_length_sse2;
+	default:
+		break;
+	}
+#endif
+	(void)level;
+	return match_length_scalar;
+}
+
+//The detected level, lowered by the WFA_SIMD_LEVEL environment variable if it names a narrower one
+static wfa::simd_level_t startup_level() {
+	wfa::simd_level_t level = wfa::detect_simd_level();
+	const char* name = std::getenv("WFA_SIMD_LEVEL");
+	wfa::simd_level_t forced;
+	if (name != nullptr and wfa::parse_simd_level(name, forced)) {
+		level = std::min(level, forced);
+	}
+	return level;
+}
+
+struct simd_dispatch_t {
+	std::atomic<wfa::simd_level_t> level;
+	std::atomic<match_kernel_t> kernel;
+};
+
+//Picked once, on first use
+static simd_dispatch_t& dispatch() {
+	static simd_dispatch_t dispatch = [] {
+		wfa::simd_level_t level = startup_level();
+		return simd_dispatch_t{ level, kernel_for(level) };
+	}();
+	return dispatch;
+}
+
+wfa::simd_level_t wfa::simd_level() {
+	return dispatch().level.load(std::memory_order_relaxed);
+}
+
+wfa::simd_level_t wfa::set_simd_level(simd_level_t level) {
+	level = std::min(level, detect_simd_level());
+	dispatch().kernel.store(kernel_for(level), std::memory_order_relaxed);
+	dispatch().level.store(level, std::memory_order_relaxed);
+	return level;
+}
+
+const char* wfa::simd_level_name(simd_level_t level) {
+	switch (level) {
+	case simd_level_t::avx512bw:
+		return "avx512bw";
+	case simd_level_t::avx2:
+		return "avx2";
+	case simd_level_t::sse2:
+		return "sse2";
+	default:
+		return "scalar";
+	}
+}
+
+bool wfa::parse_simd_level(std::string_view name, simd_level_t& level) {
+	for (simd_level_t candidate : { simd_level_t::scalar, simd_level_t::sse2, simd_level_t::avx2, simd_level_t::avx512bw }) {
+		if (name == simd_level_name(candidate)) {
+			level = candidate;
+			return true;
+		}
+	}
+	return false;
+}
+
+static int32_t match_length_with(match_kernel_t kernel, std::string_view a, int32_t v, std::string_view b, int32_t h) {
+	int32_t limit = std::min(static_cast<int32_t>(a.size()) - v, static_cast<int32_t>(b.size()) - h);
+	if (limit <= 0) {
+		return 0;
+	}
+	return kernel(a.data() + v, b.data() + h, limit);
+}
+
+int32_t wfa::match_length_simd(std::string_view a, int32_t v, std::string_view b, int32_t h) {
+	return match_length_with(dispatch().kernel.load(std::memory_order_relaxed), a, v, b, h);
+}
 
 bool wfa::extend_simd(wavefront_t& wavefront, std::string_view a, std::string_view b) {
-	wavefront_entry_t& entry = wavefront.views.back();
-	std::span<int32_t> matchfront_back(entry.data.data() + match * entry.number_per_col, entry.number_per_col);
+	wavefront_entry_t& entry = wavefront.newest();
+	int32_t* matchfront_back = entry.start_ptr(match);
+	match_kernel_t kernel = dispatch().kernel.load(std::memory_order_relaxed);
+	WFA_STAT(stats_t& stats = thread_stats();)
 	for (int32_t k = entry.low; k < entry.high + 1; ++k) {
-		int32_t starting_index = matchfront_back[k - entry.low];
-		if (starting_index == -1) {
+		int32_t offset = matchfront_back[k - entry.low];
+		if (offset == -1) {
 			continue;
 		}
-		int32_t v = starting_index - k;
-		int32_t h = starting_index;
-		
-		int32_t a_size = static_cast<int32_t>(a.size());
-		int32_t b_size = static_cast<int32_t>(b.size());
-
-		bool mismatch = false;
-
-		constexpr int32_t char_per_int = (32 / 8);
-		constexpr int32_t simd_size_true = static_cast<int32_t>(simd_type::size());
-		constexpr int32_t simd_size = static_cast<int32_t>(simd_type::size()) * char_per_int;
-
-		while (not mismatch) {
-			int32_t v_rem = a_size - v - 1;
-			int32_t h_rem = b_size - h - 1;
-			if (v_rem < simd_size or h_rem < simd_size) {
-				if (v >= a_size or h >= b_size) {
-					break;
-				}
-				const int32_t v_c = a[v];
-				const int32_t h_c = b[h];
-				if (v_c == h_c) {
-					++starting_index;
-					++v;
-					++h;
-				}
-				else {
-					mismatch = true;
-				}
-			}
-			else {
-				simd_type v_vec;
-				v_vec.copy_from(reinterpret_cast<const int32_t*>(a.data() + v), tag_type());
-				simd_type h_vec;
-				h_vec.copy_from(reinterpret_cast<const int32_t*>(b.data() + h), tag_type());
-				auto mask = v_vec == h_vec;
-				//if (!Kokkos::Experimental::all_of(mask)) {
-					for (int32_t i = 0; i < simd_size / char_per_int; ++i) {
-						if (!mask[i]) {
-							mismatch = true;
-							//starting_index += i * char_per_int;
-							int32_t base_offset = i * char_per_int;
-							for (int32_t i = 0; i < 4; ++i) {
-								if (a[v + base_offset + i] != b[h + base_offset + i]) {
-									starting_index += base_offset + i;
-									break;
-								}
-							}
-							break;
-						}
-					}
-				//}
-				//else {
-				if (!mismatch) {
-					starting_index += simd_size;
-					v += simd_size;
-					h += simd_size;
-				}
-			}
-		}
-		
-		matchfront_back[k - entry.low] = starting_index;
+		int32_t run = match_length_with(kernel, a, offset - k, b, offset);
+		matchfront_back[k - entry.low] = offset + run;
+		WFA_STAT(++stats.extended_diagonals;)
+		WFA_STAT(stats.characters += compared_characters(run, std::min(static_cast<int32_t>(a.size()) - (offset - k), static_cast<int32_t>(b.size()) - offset));)
 	}
 	return false;
 }
 
+bool wfa::extend_simd(wavefront_t& wavefront, const packed_sequence_t& a, const packed_sequence_t& b) {
+	return extend(wavefront, a, b);
+}
+
 //return soe.lookup(match, k + static_cast<int32_t>(i) - 1);
 wfa::simd_type wfa::simd_lookup(wavefront_entry_t& t, int32_t column, int32_t k, int32_t scaling) {
 	constexpr int32_t simd_size = static_cast<int32_t>(simd_type::size());
+	int32_t first = k + scaling - t.low;
+	//Within the guard cells the out of range diagonals already read as -1
+	if (first >= -wavefront_guard and first + simd_size <= t.number_per_col + wavefront_guard) {
+		return simd_load(t, column, k, scaling);
+	}
 	constexpr std::array<int32_t, 16> offset_arr = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 };
 	simd_type offsets;
 	offsets.copy_from(offset_arr.data(), tag_type());
@@ -91,90 +300,193 @@ wfa::simd_type wfa::simd_lookup(wavefront_entry_t& t, int32_t column, int32_t k,
 	auto bounds_mask = row >= 0 && row < t.number_per_col;
 	simd_type values;
 
-	Kokkos::Experimental::where(bounds_mask, values).copy_from(t.data.data() + (column * t.number_per_col + row[0]), tag_type());
+	Kokkos::Experimental::where(bounds_mask, values).copy_from(t.start_ptr(column) + row[0], tag_type());
 
 	Kokkos::Experimental::where(not bounds_mask, values) = -1;
 	
 	return values;
 }
 
-void wfa::next_simd(wavefront_t& wavefront, int32_t s, int32_t x, int32_t o, int32_t e) {
-	int32_t m_high_sx = wavefront.wave_size_high(s - x);
-	int32_t m_low_sx = wavefront.wave_size_low(s - x);
-	int32_t m_high_soe = wavefront.wave_size_high(s - o - e);
-	int32_t m_low_soe = wavefront.wave_size_low(s - o - e);
-	int32_t i_high_se = wavefront.wave_size_high(s - e);
-	int32_t i_low_se = wavefront.wave_size_low(s - e);
-	int32_t d_high_se = wavefront.wave_size_high(s - e);
-	int32_t d_low_se = wavefront.wave_size_low(s - e);
-	
-	
-	int32_t high = std::max({m_high_sx, m_high_soe, i_high_se, d_high_se}) + 1;
-	int32_t low = std::min({m_low_sx, m_low_soe, i_low_se, d_low_se}) - 1;
-	if (s < o + e) {
-		high = 0;
-		low = 0;
+wfa::simd_type wfa::simd_load(wavefront_entry_t& t, int32_t column, int32_t k, int32_t scaling) {
+	simd_type values;
+	values.copy_from(t.start_ptr(column) + (k + scaling - t.low), tag_type());
+	return values;
+}
+
+//A source column of next, read at diagonal k + scaling from start + (k + first) with first = scaling - low. A null start reads as -1
+struct next_source_t {
+	const int32_t* start = nullptr;
+	int32_t first = 0;
+};
+
+//The columns one next step reads and writes. The kernels write diagonal k to ins, del and match at k - low
+struct next_columns_t {
+	next_source_t soe_down;
+	next_source_t soe_up;
+	next_source_t se_ins;
+	next_source_t se_del;
+	next_source_t sx;
+	int32_t* ins;
+	int32_t* del;
+	int32_t* match;
+	int32_t low;
+};
+
+//Computes the vectors of diagonals k, k + width, ... up to last with plain loads, returning the first k left. Every load has to lie within the guard cells of its source
+using next_run_t = int32_t(*)(const next_columns_t&, int32_t, int32_t);
+
+struct next_kernel_t {
+	int32_t width;
+	next_run_t run;
+};
+
+#ifdef WFA_SIMD_DISPATCH
+//The kernels compute the same as the step in next_simd_step, with an offset of -1 kept as -1 rather than incremented: I + 1 + (I == -1), where the compare is -1 in the lanes it holds
+WFA_TARGET("avx512f") static __m512i load_avx512(const next_source_t& source, int32_t k) {
+	return source.start == nullptr ? _mm512_set1_epi32(-1) : _mm512_loadu_si512(source.start + (k + source.first));
+}
+
+WFA_TARGET("avx512f") static int32_t next_avx512(const next_columns_t& columns, int32_t k, int32_t last) {
+	const __m512i none = _mm512_set1_epi32(-1);
+	const __m512i one = _mm512_set1_epi32(1);
+	for (; k <= last; k += 16) {
+		__m512i I = _mm512_max_epi32(load_avx512(columns.soe_down, k), load_avx512(columns.se_ins, k));
+		I = _mm512_mask_add_epi32(I, _mm512_cmpneq_epi32_mask(I, none), I, one);
+		__m512i D = _mm512_max_epi32(load_avx512(columns.soe_up, k), load_avx512(columns.se_del, k));
+		__m512i X = load_avx512(columns.sx, k);
+		X = _mm512_mask_add_epi32(X, _mm512_cmpneq_epi32_mask(X, none), X, one);
+		__m512i M = _mm512_max_epi32(_mm512_max_epi32(I, D), X);
+		_mm512_storeu_si512(columns.ins + (k - columns.low), I);
+		_mm512_storeu_si512(columns.del + (k - columns.low), D);
+		_mm512_storeu_si512(columns.match + (k - columns.low), M);
+	}
+	return k;
+}
+
+WFA_TARGET("avx2") static __m256i load_avx2(const next_source_t& source, int32_t k) {
+	return source.start == nullptr ? _mm256_set1_epi32(-1) : _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source.start + (k + source.first)));
+}
+
+WFA_TARGET("avx2") static int32_t next_avx2(const next_columns_t& columns, int32_t k, int32_t last) {
+	const __m256i none = _mm256_set1_epi32(-1);
+	const __m256i one = _mm256_set1_epi32(1);
+	for (; k <= last; k += 8) {
+		__m256i I = _mm256_max_epi32(load_avx2(columns.soe_down, k), load_avx2(columns.se_ins, k));
+		I = _mm256_add_epi32(_mm256_add_epi32(I, one), _mm256_cmpeq_epi32(I, none));
+		__m256i D = _mm256_max_epi32(load_avx2(columns.soe_up, k), load_avx2(columns.se_del, k));
+		__m256i X = load_avx2(columns.sx, k);
+		X = _mm256_add_epi32(_mm256_add_epi32(X, one), _mm256_cmpeq_epi32(X, none));
+		__m256i M = _mm256_max_epi32(_mm256_max_epi32(I, D), X);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(columns.ins + (k - columns.low)), I);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(columns.del + (k - columns.low)), D);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(columns.match + (k - columns.low)), M);
+	}
+	return k;
+}
+
+WFA_TARGET("sse2") static __m128i load_sse2(const next_source_t& source, int32_t k) {
+	return source.start == nullptr ? _mm_set1_epi32(-1) : _mm_loadu_si128(reinterpret_cast<const __m128i*>(source.start + (k + source.first)));
+}
+
+//SSE2 has no 32-bit max, that came with SSE4.1
+WFA_TARGET("sse2") static __m128i max_sse2(__m128i a, __m128i b) {
+	__m128i greater = _mm_cmpgt_epi32(a, b);
+	return _mm_or_si128(_mm_and_si128(greater, a), _mm_andnot_si128(greater, b));
+}
+
+WFA_TARGET("sse2") static int32_t next_sse2(const next_columns_t& columns, int32_t k, int32_t last) {
+	const __m128i none = _mm_set1_epi32(-1);
+	const __m128i one = _mm_set1_epi32(1);
+	for (; k <= last; k += 4) {
+		__m128i I = max_sse2(load_sse2(columns.soe_down, k), load_sse2(columns.se_ins, k));
+		I = _mm_add_epi32(_mm_add_epi32(I, one), _mm_cmpeq_epi32(I, none));
+		__m128i D = max_sse2(load_sse2(columns.soe_up, k), load_sse2(columns.se_del, k));
+		__m128i X = load_sse2(columns.sx, k);
+		X = _mm_add_epi32(_mm_add_epi32(X, one), _mm_cmpeq_epi32(X, none));
+		__m128i M = max_sse2(max_sse2(I, D), X);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(columns.ins + (k - columns.low)), I);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(columns.del + (k - columns.low)), D);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(columns.match + (k - columns.low)), M);
+	}
+	return k;
+}
+#endif
+
+//The next kernel of a level, or none for scalar, where next_simd_step keeps to simd_type
+static next_kernel_t next_kernel_for(wfa::simd_level_t level) {
+#ifdef WFA_SIMD_DISPATCH
+	switch (level) {
+	case wfa::simd_level_t::avx512bw:
+		return { 16, next_avx512 };
+	case wfa::simd_level_t::avx2:
+		return { 8, next_avx2 };
+	case wfa::simd_level_t::sse2:
+		return { 4, next_sse2 };
+	default:
+		break;
+	}
+#endif
+	(void)level;
+	return { 0, nullptr };
+}
+
+static_assert(wfa::wavefront_guard >= 16, "the guard cells must cover a load of the widest next kernel");
+
+//The next wavefront for penalties of either type, see wfa::penalties_t and wfa::fixed_penalties_t
+template <typename penalty_t>
+static void next_simd_step(wfa::wavefront_t& wavefront, int32_t s, const penalty_t& p) {
+	using namespace wfa;
+	const int32_t x = p.x;
+	const int32_t o = p.o;
+	const int32_t e = p.e;
+	//The new wavefront spans the diagonals reachable from the source wavefronts that exist
+	int32_t high = std::numeric_limits<int32_t>::min();
+	int32_t low = std::numeric_limits<int32_t>::max();
+	if (wavefront.valid_score(s - x)) {
+		high = std::max(high, wavefront.wave_size_high(s - x));
+		low = std::min(low, wavefront.wave_size_low(s - x));
+	}
+	if (wavefront.valid_score(s - o - e)) {
+		high = std::max(high, wavefront.wave_size_high(s - o - e) + 1);
+		low = std::min(low, wavefront.wave_size_low(s - o - e) - 1);
+	}
+	if (wavefront.valid_score(s - e)) {
+		high = std::max(high, wavefront.wave_size_high(s - e) + 1);
+		low = std::min(low, wavefront.wave_size_low(s - e) - 1);
 	}
 
 	auto& wave_cur = wavefront.insert(low, high);
+	WFA_STAT(++thread_stats().scores;)
 
 	constexpr int32_t simd_size = static_cast<int32_t>(simd_type::size());
 
-	int32_t k = low;
-	while (high - k + 1 > simd_size) {
-		simd_type M_soe_down_vec;
-		simd_type M_soe_up_vec;
-		
-		if (s - o - e >= 0) {
-			int32_t soe_index = wavefront.mapping[s - o - e];
-			if (soe_index != -1) {
-				auto& soe = wavefront.views[soe_index];
-				M_soe_down_vec = simd_lookup(soe, match, k, -1);
-				M_soe_up_vec = simd_lookup(soe, match, k, +1);
-			}
-			else {
-				M_soe_down_vec = simd_type(-1);
-				M_soe_up_vec = simd_type(-1);
-			}
-		}
-		else {
-			M_soe_down_vec = simd_type(-1);
-			M_soe_up_vec = simd_type(-1);
-		}
+	//The sources are looked up after the insert, which can move the slots of a ring
+	wavefront_entry_t* sx = wavefront.valid_score(s - x) ? &wavefront.views[wavefront.index(s - x)] : nullptr;
+	wavefront_entry_t* soe = wavefront.valid_score(s - o - e) ? &wavefront.views[wavefront.index(s - o - e)] : nullptr;
+	wavefront_entry_t* se = wavefront.valid_score(s - e) ? &wavefront.views[wavefront.index(s - e)] : nullptr;
 
-		simd_type I_se_down_vec;
-		simd_type D_se_up_vec;
-		if (s - e >= 0) {
-			int32_t se_index = wavefront.mapping[s - e];
-			if (se_index != -1) {
-				auto& se = wavefront.views[se_index];
-				I_se_down_vec = simd_lookup(se, ins, k, -1);
-				D_se_up_vec = simd_lookup(se, del, k, +1);
-			}
-			else {
-				I_se_down_vec = simd_type(-1);
-				D_se_up_vec = simd_type(-1);
-			}
-		}
-		else {
-			I_se_down_vec = simd_type(-1);
-			D_se_up_vec = simd_type(-1);
+	//A vector of width lanes starting at a diagonal in [guarded_low, reach - width] only reads the sources within their guard cells, reaching one diagonal below and width above k on the s-o-e and s-e wavefronts.
+	//Only a source far narrower than the new wavefront, after a reduction or for a mismatch score that trails the gap ones, leaves vectors at the ends to the bounds checked simd_lookup
+	int32_t guarded_low = low;
+	int32_t reach = high + 1;
+	if (sx != nullptr) {
+		guarded_low = std::max(guarded_low, sx->low - wavefront_guard);
+		reach = std::min(reach, sx->high + wavefront_guard + 1);
+	}
+	for (wavefront_entry_t* source : { soe, se }) {
+		if (source != nullptr) {
+			guarded_low = std::max(guarded_low, source->low - wavefront_guard + 1);
+			reach = std::min(reach, source->high + wavefront_guard);
 		}
+	}
 
-		simd_type M_sx_vec;
-		if (s - x >= 0) {
-			int32_t sx_index = wavefront.mapping[s - x];
-			if (sx_index != -1) {
-				auto& sx = wavefront.views[sx_index];
-				M_sx_vec = simd_lookup(sx, match, k, 0);
-			}
-			else {
-				M_sx_vec = simd_type(-1);
-			}
-		}
-		else {
-			M_sx_vec = simd_type(-1);
-		}
+	//One vector of diagonals from k, reading the sources with load, either simd_load or simd_lookup. A missing source reads as -1
+	auto step = [&](int32_t k, auto load) {
+		simd_type M_soe_down_vec = soe != nullptr ? load(*soe, match, k, -1) : simd_type(-1);
+		simd_type M_soe_up_vec = soe != nullptr ? load(*soe, match, k, +1) : simd_type(-1);
+		simd_type I_se_down_vec = se != nullptr ? load(*se, ins, k, -1) : simd_type(-1);
+		simd_type D_se_up_vec = se != nullptr ? load(*se, del, k, +1) : simd_type(-1);
+		simd_type M_sx_vec = sx != nullptr ? load(*sx, match, k, 0) : simd_type(-1);
 
 		simd_type I = Kokkos::max(M_soe_down_vec, I_se_down_vec);
 		Kokkos::Experimental::where(I != -1, I) = I + 1;
@@ -188,9 +500,36 @@ void wfa::next_simd(wavefront_t& wavefront, int32_t s, int32_t x, int32_t o, int
 		I.copy_to(wave_cur.start_ptr(ins) + (k - low), tag_type());
 		D.copy_to(wave_cur.start_ptr(del) + (k - low), tag_type());
 		M.copy_to(wave_cur.start_ptr(match) + (k - low), tag_type());
+	};
+	auto checked = [](wavefront_entry_t& t, int32_t column, int32_t k, int32_t scaling) { return simd_lookup(t, column, k, scaling); };
+	auto unchecked = [](wavefront_entry_t& t, int32_t column, int32_t k, int32_t scaling) { return simd_load(t, column, k, scaling); };
 
-		k += simd_size;
+	//The vectors of simd_type from low up to high - simd_size, split into the checked ends and the guarded middle. The middle runs through the kernel of wfa::simd_level,
+	//as wide as the CPU allows whatever simd_type the build was configured with, and falls back to simd_type for the scalar level or off x86
+	int32_t last = high - simd_size;
+	int32_t k = low;
+	for (; k <= last and k < guarded_low; k += simd_size) {
+		step(k, checked);
+	}
+	next_kernel_t kernel = next_kernel_for(dispatch().level.load(std::memory_order_relaxed));
+	if (kernel.run != nullptr and k >= guarded_low) {
+		auto source = [&](wavefront_entry_t* entry, int32_t column, int32_t scaling) {
+			return entry == nullptr ? next_source_t{} : next_source_t{ entry->start_ptr(column), scaling - entry->low };
+		};
+		next_columns_t columns{
+			source(soe, match, -1), source(soe, match, +1), source(se, ins, -1), source(se, del, +1), source(sx, match, 0),
+			wave_cur.start_ptr(ins), wave_cur.start_ptr(del), wave_cur.start_ptr(match), low
+		};
+		k = kernel.run(columns, k, std::min(high, reach) - kernel.width);
+	}
+	for (; k <= std::min(last, reach - simd_size); k += simd_size) {
+		step(k, unchecked);
 	}
+	for (; k <= last; k += simd_size) {
+		step(k, checked);
+	}
+	WFA_STAT(thread_stats().vector_diagonals += k - low;)
+	WFA_STAT(thread_stats().scalar_diagonals += high + 1 - k;)
 
 	for (; k < high + 1; ++k) {
 		wave_cur.no_bound(ins, k - low) = std::max({ wavefront.lookup(s - o - e, match, k - 1), wavefront.lookup(s - e, ins, k - 1) });
@@ -210,12 +549,21 @@ void wfa::next_simd(wavefront_t& wavefront, int32_t s, int32_t x, int32_t o, int
 
 }
 
-int32_t wfa::wavefront_simd(std::string_view a, std::string_view b, int32_t x, int32_t o, int32_t e, wavefront_arena_t& arena) {
-	wavefront_t wavefront(arena);
+void wfa::next_simd(wavefront_t& wavefront, int32_t s, int32_t x, int32_t o, int32_t e) {
+	next_simd_step(wavefront, s, penalties_t{ x, o, e });
+}
+
+//Runs the alignment, with the adaptive reduction heuristic unless reduction is null. Returns -1 once the next score would pass max_score. sequence_t is std::string_view or wfa::packed_sequence_t, penalty_t is wfa::penalties_t or a wfa::fixed_penalties_t
+template <typename sequence_t, typename penalty_t>
+static int32_t align_simd(wfa::wavefront_t& wavefront, const sequence_t& a, const sequence_t& b, const penalty_t& p, const wfa::reduction_t* reduction, int32_t max_score = std::numeric_limits<int32_t>::max()) {
+	using namespace wfa;
+	const int32_t x = p.x;
+	const int32_t o = p.o;
+	const int32_t e = p.e;
 	auto& first = wavefront.insert(0, 0);
-	first.data[0] = -1;
-	first.data[1] = -1;
-	first.data[2] = 0;
+	first.no_bound(ins, 0) = -1;
+	first.no_bound(del, 0) = -1;
+	first.no_bound(match, 0) = 0;
 
 	bool matched = false;
 
@@ -224,13 +572,19 @@ int32_t wfa::wavefront_simd(std::string_view a, std::string_view b, int32_t x, i
 	int32_t final_k = static_cast<int32_t>(b.size()) - static_cast<int32_t>(a.size());
 	int32_t final_offset = static_cast<int32_t>(b.size());
 
+	WFA_STAT(++thread_stats().alignments;)
 	while (not matched) {
+		WFA_STAT(uint64_t extend_start = stats_clock();)
 		extend_simd(wavefront, a, b);
-		auto& matchfront_back = wavefront.views.back();
+		WFA_STAT(thread_stats().extend_cycles += stats_clock() - extend_start;)
+		auto& matchfront_back = wavefront.newest();
 		if (matchfront_back.lookup(match, final_k) >= final_offset) {
 			break;
 		}
 		else {
+			if (reduction != nullptr) {
+				reduce(wavefront, static_cast<int32_t>(a.size()), static_cast<int32_t>(b.size()), *reduction);
+			}
 			score = score + 1;
 			while (not (
 				wavefront.valid_score(score - x)
@@ -240,9 +594,67 @@ int32_t wfa::wavefront_simd(std::string_view a, std::string_view b, int32_t x, i
 				wavefront.insert();
 				++score;
 			}
+			if (score > max_score) {
+				return -1;
+			}
 		}
-		next_simd(wavefront, score, x, o, e);
+		WFA_STAT(uint64_t next_start = stats_clock();)
+		next_simd_step(wavefront, score, p);
+		WFA_STAT(thread_stats().next_cycles += stats_clock() - next_start;)
 	}
-	arena.current_index = 0;
+	return score;
+}
+
+int32_t wfa::wavefront_simd(std::string_view a, std::string_view b, int32_t x, int32_t o, int32_t e, wavefront_arena_t& arena) {
+	wavefront_t wavefront(arena);
+	wavefront.ring(std::max(x, o + e));
+	int32_t score = dispatch_penalties(x, o, e, [&](auto p) { return align_simd(wavefront, a, b, p, nullptr); });
+	arena.reset();
 	return -1*score;
-}
\ No newline at end of file
+}
+
+int32_t wfa::wavefront_simd(std::string_view a, std::string_view b, int32_t x, int32_t o, int32_t e, wavefront_arena_t& arena, std::string& cigar) {
+	wavefront_t wavefront(arena);
+	int32_t score = dispatch_penalties(x, o, e, [&](auto p) { return align_simd(wavefront, a, b, p, nullptr); });
+	backtrace(wavefront, a, b, score, x, o, e, cigar);
+	arena.reset();
+	return -1*score;
+}
+
+int32_t wfa::wavefront_simd(std::string_view a, std::string_view b, int32_t x, int32_t o, int32_t e, wavefront_arena_t& arena, const reduction_t& reduction) {
+	wavefront_t wavefront(arena);
+	wavefront.ring(std::max(x, o + e));
+	int32_t score = dispatch_penalties(x, o, e, [&](auto p) { return align_simd(wavefront, a, b, p, &reduction); });
+	arena.reset();
+	return -1*score;
+}
+
+int32_t wfa::wavefront_simd(const packed_sequence_t& a, const packed_sequence_t& b, int32_t x, int32_t o, int32_t e, wavefront_arena_t& arena) {
+	wavefront_t wavefront(arena);
+	wavefront.ring(std::max(x, o + e));
+	int32_t score = dispatch_penalties(x, o, e, [&](auto p) { return align_simd(wavefront, a, b, p, nullptr); });
+	arena.reset();
+	return -1*score;
+}
+int32_t wfa::wavefront_simd(std::string_view a, std::string_view b, int32_t x, int32_t o, int32_t e, wavefront_arena_t& arena, int32_t max_score) {
+	wavefront_t wavefront(arena);
+	wavefront.ring(std::max(x, o + e));
+	int32_t score = dispatch_penalties(x, o, e, [&](auto p) { return align_simd(wavefront, a, b, p, nullptr, max_score); });
+	arena.reset();
+	if (score == -1) {
+		return score_exceeded;
+	}
+	return -1*score;
+}
+
+template <int32_t X, int32_t O, int32_t E>
+int32_t wfa::wavefront_simd(std::string_view a, std::string_view b, wavefront_arena_t& arena) {
+	wavefront_t wavefront(arena);
+	wavefront.ring(std::max(X, O + E));
+	int32_t score = align_simd(wavefront, a, b, fixed_penalties_t<X, O, E>{}, nullptr);
+	arena.reset();
+	return -1*score;
+}
+
+template int32_t wfa::wavefront_simd<4, 6, 2>(std::string_view a, std::string_view b, wavefront_arena_t& arena);
+template int32_t wfa::wavefront_simd<2, 3, 1>(std::string_view a, std::string_view b, wavefront_arena_t& arena);
@@ -0,0 +1,83 @@
+#include "include/wfa_stats.hpp"
+
+#include "fmt/format.h"
+#include <algorithm>
+#include <deque>
+#include <iterator>
+#include <mutex>
+
+//Every thread's counters, kept after the thread exits so its work still shows in the totals. A deque never moves its elements, so the references threads hold stay valid
+struct stats_registry_t {
+	std::mutex mutex;
+	std::deque<wfa::stats_t> threads;
+};
+
+static stats_registry_t& registry() {
+	static stats_registry_t registry;
+	return registry;
+}
+
+wfa::stats_t& wfa::stats_t::operator+=(const stats_t& rhs) {
+	alignments += rhs.alignments;
+	scores += rhs.scores;
+	null_wavefronts += rhs.null_wavefronts;
+	vector_diagonals += rhs.vector_diagonals;
+	scalar_diagonals += rhs.scalar_diagonals;
+	extended_diagonals += rhs.extended_diagonals;
+	characters += rhs.characters;
+	vector_characters += rhs.vector_characters;
+	tail_characters += rhs.tail_characters;
+	arena_peak = std::max(arena_peak, rhs.arena_peak);
+	extend_cycles += rhs.extend_cycles;
+	next_cycles += rhs.next_cycles;
+	return *this;
+}
+
+wfa::stats_t& wfa::register_thread_stats() {
+	stats_registry_t& stats = registry();
+	std::lock_guard lock(stats.mutex);
+	return stats.threads.emplace_back();
+}
+
+std::vector<wfa::stats_t> wfa::collect_stats() {
+	stats_registry_t& stats = registry();
+	std::lock_guard lock(stats.mutex);
+	return std::vector<stats_t>(stats.threads.begin(), stats.threads.end());
+}
+
+void wfa::reset_stats() {
+	stats_registry_t& stats = registry();
+	std::lock_guard lock(stats.mutex);
+	std::fill(stats.threads.begin(), stats.threads.end(), stats_t{});
+}
+
+static void append_json(fmt::memory_buffer& out, const wfa::stats_t& stats) {
+	fmt::format_to(std::back_inserter(out),
+		"{{\"alignments\": {}, \"scores\": {}, \"null_wavefronts\": {}, \"vector_diagonals\": {}, \"scalar_diagonals\": {}, "
+		"\"extended_diagonals\": {}, \"characters\": {}, \"vector_characters\": {}, \"tail_characters\": {}, "
+		"\"arena_peak\": {}, \"extend_cycles\": {}, \"next_cycles\": {}}}",
+		stats.alignments, stats.scores, stats.null_wavefronts, stats.vector_diagonals, stats.scalar_diagonals,
+		stats.extended_diagonals, stats.characters, stats.vector_characters, stats.tail_characters,
+		stats.arena_peak, stats.extend_cycles, stats.next_cycles);
+}
+
+std::string wfa::stats_json() {
+	std::vector<stats_t> threads = collect_stats();
+	stats_t total;
+	for (const stats_t& thread : threads) {
+		total += thread;
+	}
+
+	fmt::memory_buffer out;
+	fmt::format_to(std::back_inserter(out), "{{\"enabled\": {}, \"total\": ", stats_enabled);
+	append_json(out, total);
+	fmt::format_to(std::back_inserter(out), ", \"threads\": [");
+	for (size_t i = 0; i < threads.size(); ++i) {
+		if (i != 0) {
+			fmt::format_to(std::back_inserter(out), ", ");
+		}
+		append_json(out, threads[i]);
+	}
+	fmt::format_to(std::back_inserter(out), "]}}");
+	return fmt::to_string(out);
+}
@@ -1,59 +1,245 @@
-#include "include/data_gen.hpp"
+#include "include/sequence_reader.hpp"
+#include "include/pair_dataset.hpp"
+#include "include/alignment_output.hpp"
 #include "include/wfa_simd.hpp"
+#include "include/wfa_stats.hpp"
+#include "include/wfa_linear.hpp"
 #include "include/wfa.hpp"
-#include "include/naive.hpp"
 #include "fmt/format.h"
-#include "fmt/chrono.h"
-#include <chrono>
-
-//Naive is disabled for performance reasons
-
-int main() {
-    auto sequences = wfa::modify_sequences(100, 100000, 0.2);
-    /*int32_t i = 0;
-    wfa::wavefront_arena_t arena;
-    for (const auto& pair : sequences) {
-        const std::string& a = pair.first;
-        const std::string& b = pair.second;
-        auto score = wfa::wavefront_simd(a, b, 4, 6, 2, arena);
-        auto score2 = wfa::naive(a, b, 4, 6, 2);
-        auto score3 = wfa::wavefront(a, b, 4, 6, 2, arena);
-        if (score != score2 || score != score3) {
-            fmt::println("---Error---\nScore: {} {} {}\nA: {}\nB: {}", score, score2, score3, a, b);
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstdio>
+#include <deque>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+//Aligns pairs of sequences read from FASTA or FASTQ files or a pair dataset on a set of worker threads, writing one line per pair to stdout in input order:
+//the two names and the score (plus the CIGAR with --cigar), or PAF or SAM. Pairs from a dataset have no names, so they are named by their index
+
+static void usage(const char* program) {
+    fmt::println(stderr, "Usage: {} [options] <a.fa|a.fq|pairs.wfad> [b.fa|b.fq]", program);
+    fmt::println(stderr, "Aligns the nth record of the first file against the nth record of the second, consecutive records of a single interleaved file, or the pairs of a dataset");
+    fmt::println(stderr, "  -x <int>             mismatch penalty, at least 1 (default 4)");
+    fmt::println(stderr, "  -o <int>             gap open penalty (default 6)");
+    fmt::println(stderr, "  -e <int>             gap extend penalty, at least 1 (default 2)");
+    fmt::println(stderr, "  -m, --mode <mode>    affine, linear (x and e per base) or edit (default affine)");
+    fmt::println(stderr, "  -f, --format <fmt>   tsv, paf or sam (default tsv). paf and sam include the CIGAR in affine mode");
+    fmt::println(stderr, "  -c, --cigar          add the CIGAR to tsv output (affine only)");
+    fmt::println(stderr, "  -t, --threads <int>  worker threads, 0 for one per hardware thread (default 0)");
+    fmt::println(stderr, "  -s, --stats          print the engine counters as JSON to stderr, in builds with WFA_STATS");
+    fmt::println(stderr, "  --simd <level>       extend kernels: scalar, sse2, avx2 or avx512bw, capped at what the CPU supports (default the widest it supports)");
+    fmt::println(stderr, "  -w, --write <path>   write the FASTA/FASTQ pairs to a dataset instead of aligning them");
+    fmt::println(stderr, "  -p, --packed         pack the dataset 2 bits per base, for A, C, G and T only");
+}
+
+static bool parse_int(std::string_view text, int32_t& value, int32_t minimum) {
+    auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+    return error == std::errc() and end == text.data() + text.size() and value >= minimum;
+}
+
+//A pair to align. The views point into the mapped input, or into storage for the few strings that had to be built
+struct input_pair_t {
+    std::string_view a_name;
+    std::string_view b_name;
+    std::string_view a;
+    std::string_view b;
+};
+
+//The pairs a worker formats into one block of output
+constexpr size_t chunk_size = 256;
+
+int main(int argc, char* argv[]) {
+    int32_t x = 4, o = 6, e = 2; // Default penalty values
+    std::string_view mode = "affine";
+    std::string_view format = "tsv";
+    bool cigar = false;
+    int32_t threads = 0;
+    std::string dataset_path;
+    bool packed = false;
+    bool stats = false;
+    wfa::simd_level_t level;
+    std::vector<std::string> paths;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "-x" or arg == "-o" or arg == "-e") {
+            int32_t& penalty = arg == "-x" ? x : (arg == "-o" ? o : e);
+            //Every wavefront has to cost more than the one it extends, so gaps can not be free
+            if (not has_value or not parse_int(argv[++i], penalty, arg == "-o" ? 0 : 1)) {
+                usage(argv[0]);
+                return 1;
+            }
+        }
+        else if ((arg == "-t" or arg == "--threads") and has_value and parse_int(argv[i + 1], threads, 0)) {
+            ++i;
+        }
+        else if ((arg == "-m" or arg == "--mode") and has_value) {
+            mode = argv[++i];
+        }
+        else if ((arg == "-f" or arg == "--format") and has_value) {
+            format = argv[++i];
+        }
+        else if (arg == "-c" or arg == "--cigar") {
+            cigar = true;
+        }
+        else if ((arg == "-w" or arg == "--write") and has_value) {
+            dataset_path = argv[++i];
+        }
+        else if (arg == "-p" or arg == "--packed") {
+            packed = true;
+        }
+        else if (arg == "-s" or arg == "--stats") {
+            stats = true;
+        }
+        else if (arg == "--simd" and has_value and wfa::parse_simd_level(argv[i + 1], level)) {
+            wfa::set_simd_level(level);
+            ++i;
+        }
+        else if (arg.starts_with("-") or paths.size() == 2) {
+            usage(argv[0]);
+            return 1;
         }
         else {
-            fmt::println("Success: {}", i);
+            paths.emplace_back(arg);
         }
-        ++i;
-    }*/
+    }
+    if (paths.empty() or (mode != "affine" and mode != "linear" and mode != "edit") or (format != "tsv" and format != "paf" and format != "sam") or (cigar and mode != "affine")) {
+        usage(argv[0]);
+        return 1;
+    }
+    bool traceback = mode == "affine" and (cigar or format != "tsv");
 
-    auto start = std::chrono::system_clock::now();
-    wfa::wavefront_arena_t arena1;
-    for (const auto& pair : sequences) {
-        const std::string& a = pair.first;
-        const std::string& b = pair.second;
-        wfa::wavefront(a, b, 4, 6, 2, arena1);
+    //Every pair is gathered up front, as views wherever the input allows
+    std::vector<input_pair_t> pairs;
+    std::deque<std::string> storage;
+    wfa::pair_dataset_t dataset(paths[0]);
+    std::vector<wfa::mapped_file_t> files;
+    if (dataset.is_open() and paths.size() == 1 and dataset_path.empty()) {
+        pairs.resize(dataset.size());
+        for (size_t i = 0; i < dataset.size(); ++i) {
+            std::string_view name = storage.emplace_back(std::to_string(i));
+            pairs[i].a_name = name;
+            pairs[i].b_name = name;
+            if (dataset.packed()) {
+                std::string& a = storage.emplace_back();
+                std::string& b = storage.emplace_back();
+                dataset.unpack(i, a, b);
+                pairs[i].a = a;
+                pairs[i].b = b;
+            }
+            else {
+                std::tie(pairs[i].a, pairs[i].b) = dataset[i];
+            }
+        }
     }
-    auto end = std::chrono::system_clock::now();
-    fmt::println("Wavefront: {:%T}", end - start);
-
-    start = std::chrono::system_clock::now();
-    wfa::wavefront_arena_t arena2;
-    for (const auto& pair : sequences) {
-        const std::string& a = pair.first;
-        const std::string& b = pair.second;
-        wfa::wavefront_simd(a, b, 4, 6, 2, arena2);
+    else {
+        for (const auto& path : paths) {
+            files.emplace_back(path);
+            if (not files.back().is_open()) {
+                fmt::println(stderr, "Could not open {}", path);
+                return 1;
+            }
+        }
+        wfa::pair_reader_t reader = files.size() == 2 ? wfa::pair_reader_t(files[0].contents(), files[1].contents()) : wfa::pair_reader_t(files[0].contents());
+
+        if (not dataset_path.empty()) {
+            if (not wfa::write_dataset(dataset_path, reader, packed)) {
+                fmt::println(stderr, "Could not write {}", dataset_path);
+                return 1;
+            }
+            return 0;
+        }
+
+        wfa::sequence_record_t a;
+        wfa::sequence_record_t b;
+        auto inside = [&](std::string_view view, const wfa::mapped_file_t& file) {
+            return view.data() >= file.data and view.data() <= file.data + file.size;
+        };
+        while (reader.next(a, b)) {
+            //Sequences joined from several lines live in the reader's buffers, which the next record reuses
+            if (not inside(a.sequence, files.front())) {
+                a.sequence = storage.emplace_back(a.sequence);
+            }
+            if (not inside(b.sequence, files.back())) {
+                b.sequence = storage.emplace_back(b.sequence);
+            }
+            pairs.push_back({ a.name, b.name, a.sequence, b.sequence });
+        }
+        if (reader.failed()) {
+            fmt::println(stderr, "Malformed record after {} pairs", pairs.size());
+            return 1;
+        }
     }
-    end = std::chrono::system_clock::now();
-    fmt::println("Wavefront SIMD: {:%T}", end - start);
-
-    /*start = std::chrono::system_clock::now();
-    for (const auto& pair : sequences) {
-        const std::string& a = pair.first;
-        const std::string& b = pair.second;
-        wfa::naive(a, b, 4, 6, 2);
+
+    if (format == "sam") {
+        fmt::memory_buffer header;
+        wfa::format_sam_header(header);
+        std::fwrite(header.data(), 1, header.size(), stdout);
     }
-    end = std::chrono::system_clock::now();
-    fmt::println("Naive: {:%T}", end - start);*/
 
-}
\ No newline at end of file
+    //Workers take chunks in order and format each into a block of its own, which the writer puts back in order
+    size_t chunks = (pairs.size() + chunk_size - 1) / chunk_size;
+    size_t workers = threads > 0 ? static_cast<size_t>(threads) : std::max(std::thread::hardware_concurrency(), 1u);
+    workers = std::max<size_t>(std::min(workers, chunks), 1);
+    std::atomic<size_t> next_chunk = 0;
+    wfa::ordered_writer_t writer(stdout, 4 * workers);
+
+    auto work = [&] {
+        wfa::wavefront_arena_t arena;
+        std::string operations;
+        for (size_t chunk = next_chunk++; chunk < chunks; chunk = next_chunk++) {
+            fmt::memory_buffer out;
+            for (size_t i = chunk * chunk_size; i < std::min((chunk + 1) * chunk_size, pairs.size()); ++i) {
+                const input_pair_t& pair = pairs[i];
+                int32_t score;
+                operations.clear();
+                if (mode == "linear") {
+                    score = wfa::wavefront_linear_simd(pair.a, pair.b, x, e, arena);
+                }
+                else if (mode == "edit") {
+                    score = wfa::wavefront_edit_simd(pair.a, pair.b, arena);
+                }
+                else if (traceback) {
+                    score = wfa::wavefront_simd(pair.a, pair.b, x, o, e, arena, operations);
+                }
+                else {
+                    score = wfa::wavefront_simd(pair.a, pair.b, x, o, e, arena);
+                }
+
+                wfa::alignment_record_t record{ pair.a_name, pair.b_name, static_cast<int32_t>(pair.a.size()), static_cast<int32_t>(pair.b.size()), score, operations, pair.b };
+                if (format == "paf") {
+                    wfa::format_paf(out, record);
+                }
+                else if (format == "sam") {
+                    wfa::format_sam(out, record);
+                }
+                else {
+                    fmt::format_to(std::back_inserter(out), "{}\t{}\t{}", pair.a_name, pair.b_name, score);
+                    if (cigar) {
+                        out.push_back('\t');
+                        wfa::append_cigar(out, operations);
+                    }
+                    out.push_back('\n');
+                }
+            }
+            writer.submit(chunk, std::move(out));
+        }
+    };
+    {
+        std::vector<std::jthread> pool;
+        for (size_t worker = 1; worker < workers; ++worker) {
+            pool.emplace_back(work);
+        }
+        work();
+    }
+    writer.finish();
+    if (stats) {
+        fmt::println(stderr, "{}", wfa::stats_json());
+    }
+    return 0;
+}
@@ -185,6 +185,70 @@ TEST_CASE("Comprehensive Tests for wfa::naive and wfa::wavefront_dp Alignments")
     }
 }
 
+TEST_CASE("Gap-linear wfa::naive_linear") {
+    SECTION("Edit Distance") {
+        REQUIRE(wfa::naive_linear("kitten", "sitting", 1, 1) == -3);
+        REQUIRE(wfa::naive_linear("GATTACA", "GATTACA", 1, 1) == 0);
+        REQUIRE(wfa::naive_linear("", "ACGT", 1, 1) == -4);
+    }
+
+    SECTION("Gaps Cheaper Than A Mismatch") {
+        // One deletion and one insertion (2 + 2) beat the mismatch (5)
+        REQUIRE(wfa::naive_linear("GATTACA", "GATCACA", 5, 2) == -4);
+        REQUIRE(wfa::naive_linear("GATTACA", "GATCACA", 3, 2) == -3);
+    }
+}
+
+TEST_CASE("Two-piece gap-affine wfa::naive_affine2p") {
+    SECTION("Matches Single Piece When The Second Model Is Never Cheaper") {
+        std::string a = "GATTACAGATTACA";
+        std::string b = "GATTTTTACAGACA";
+        REQUIRE(wfa::naive_affine2p(a, b, 4, 6, 2, 1000, 2) == wfa::naive(a, b, 4, 6, 2));
+    }
+
+    SECTION("Long Gaps Use The Second Model") {
+        std::string a = "ACGT" + std::string(30, 'G') + "TGCA";
+        std::string b = "ACGTTGCA";
+        // 30 deleted bases cost 6 + 30 * 2 with the first model, 24 + 30 * 1 with the second
+        REQUIRE(wfa::naive_affine2p(a, b, 4, 6, 2, 24, 1) == -54);
+        REQUIRE(wfa::naive_affine2p("GATTACA", "GATACA", 4, 6, 2, 24, 1) == -8);
+    }
+}
+
+TEST_CASE("Ends-free wfa::naive_ends_free") {
+    SECTION("Matches Global Without Free Ends") {
+        std::string a = "GATTACAGATTACA";
+        std::string b = "GATTTTTACAGACA";
+        REQUIRE(wfa::naive_ends_free(a, b, 4, 6, 2, 0, 0, 0, 0) == wfa::naive(a, b, 4, 6, 2));
+    }
+
+    SECTION("Read Inside A Reference") {
+        std::string b = "GATTACA";
+        std::string a = "CCCCC" + b + "TTTT";
+        int32_t n = static_cast<int32_t>(a.size());
+        REQUIRE(wfa::naive_ends_free(a, b, 4, 6, 2, n, n, 0, 0) == 0);
+        // Only the prefix is free, so the 4 trailing bases are a deletion
+        REQUIRE(wfa::naive_ends_free(a, b, 4, 6, 2, n, 0, 0, 0) == -14);
+        // The free ends of b do not help, b has nothing to skip
+        REQUIRE(wfa::naive_ends_free(a, b, 4, 6, 2, 0, 0, 7, 7) == wfa::naive(a, b, 4, 6, 2));
+    }
+}
+
+TEST_CASE("Extension wfa::naive_extension") {
+    SECTION("Stops Where The Sequences Diverge") {
+        std::string a = "GATTACA" + std::string(10, 'C');
+        std::string b = "GATTACA" + std::string(10, 'G');
+        // 7 matched pairs earn 2 each, every later mismatch costs more than it earns
+        REQUIRE(wfa::naive_extension(a, b, 4, 6, 2, 1) == 14);
+        REQUIRE(wfa::naive_extension(a, b, 4, 6, 2, 3) == 42 + 10 * 2);
+    }
+
+    SECTION("Empty Extension") {
+        REQUIRE(wfa::naive_extension("CCCC", "GGGG", 4, 6, 2, 1) == 0);
+        REQUIRE(wfa::naive_extension("", "ACGT", 4, 6, 2, 1) == 0);
+    }
+}
+
 // Main function to run the Catch2 test session
 int main(int argc, char* argv[]) {
     Catch::Session session; // Create a Catch2 session to run the tests
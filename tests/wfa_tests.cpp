@@ -0,0 +1,956 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "include/wfa.hpp"
+#include "include/wfa_simd.hpp"
+#include "include/wfa_bidirectional.hpp"
+#include "include/wfa_piggyback.hpp"
+#include "include/wfa_batch.hpp"
+#include "include/wfa_parallel.hpp"
+#include "include/wfa_linear.hpp"
+#include "include/wfa_affine2p.hpp"
+#include "include/wfa_ends_free.hpp"
+#include "include/wfa_extension.hpp"
+#include "include/sequence_reader.hpp"
+#include "include/pair_dataset.hpp"
+#include "include/alignment_output.hpp"
+#include "include/wfa_stats.hpp"
+#include "include/naive.hpp"
+#include "include/data_gen.hpp"
+#include <string>
+#include <string_view>
+#include <algorithm>
+#include <tuple>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+//Replays a cigar against both sequences, returning the penalty it encodes or -1 if it does not describe an alignment of a and b
+static int32_t cigar_penalty(std::string_view cigar, std::string_view a, std::string_view b, int32_t x, int32_t o, int32_t e) {
+    size_t v = 0, h = 0;
+    int32_t penalty = 0;
+    char previous = 'M';
+    for (char op : cigar) {
+        switch (op) {
+        case 'M':
+            if (v >= a.size() || h >= b.size() || a[v] != b[h]) return -1;
+            ++v;
+            ++h;
+            break;
+        case 'X':
+            if (v >= a.size() || h >= b.size() || a[v] == b[h]) return -1;
+            ++v;
+            ++h;
+            penalty += x;
+            break;
+        case 'I':
+            if (h >= b.size()) return -1;
+            ++h;
+            penalty += previous == 'I' ? e : o + e;
+            break;
+        case 'D':
+            if (v >= a.size()) return -1;
+            ++v;
+            penalty += previous == 'D' ? e : o + e;
+            break;
+        default:
+            return -1;
+        }
+        previous = op;
+    }
+    return (v == a.size() && h == b.size()) ? penalty : -1;
+}
+
+TEST_CASE("Traceback of wfa::wavefront and wfa::wavefront_simd") {
+    int x = 4, o = 6, e = 2; // Default penalty values
+    wfa::wavefront_arena_t arena;
+    std::string cigar;
+
+    SECTION("Identical Sequences") {
+        REQUIRE(wfa::wavefront("GATTACA", "GATTACA", x, o, e, arena, cigar) == 0);
+        REQUIRE(cigar == "MMMMMMM");
+        REQUIRE(wfa::wavefront_simd("GATTACA", "GATTACA", x, o, e, arena, cigar) == 0);
+        REQUIRE(cigar == "MMMMMMM");
+    }
+
+    SECTION("Single Mismatch") {
+        REQUIRE(wfa::wavefront("GATTACA", "GACTACA", x, o, e, arena, cigar) == -4);
+        REQUIRE(cigar == "MMXMMMM");
+    }
+
+    SECTION("Single Insertion") {
+        REQUIRE(wfa::wavefront_simd("GATTACA", "GATTTACA", x, o, e, arena, cigar) == -8);
+        REQUIRE(cigar_penalty(cigar, "GATTACA", "GATTTACA", x, o, e) == 8);
+        REQUIRE(std::count(cigar.begin(), cigar.end(), 'I') == 1);
+    }
+
+    SECTION("Consecutive Gaps") {
+        REQUIRE(wfa::wavefront("AAAAAA", "AA", x, o, e, arena, cigar) == -14);
+        REQUIRE(cigar_penalty(cigar, "AAAAAA", "AA", x, o, e) == 14);
+        REQUIRE(std::count(cigar.begin(), cigar.end(), 'D') == 4);
+    }
+
+    SECTION("Empty Sequences") {
+        REQUIRE(wfa::wavefront("", "", x, o, e, arena, cigar) == 0);
+        REQUIRE(cigar.empty());
+        REQUIRE(wfa::wavefront_simd("", "AGCT", x, o, e, arena, cigar) == -14);
+        REQUIRE(cigar == "IIII");
+    }
+
+    SECTION("Buffer Is Overwritten Between Calls") {
+        wfa::wavefront("AGCTTAC", "CGTTAGC", x, o, e, arena, cigar);
+        wfa::wavefront("GATTACA", "GATTACA", x, o, e, arena, cigar);
+        REQUIRE(cigar == "MMMMMMM");
+    }
+
+    SECTION("Random Sequences Match Naive") {
+        auto sequences = wfa::modify_sequences(150, 200, 0.1);
+        std::string cigar_simd;
+        for (const auto& [a, b] : sequences) {
+            int32_t expected = wfa::naive(a, b, x, o, e);
+            REQUIRE(wfa::wavefront(a, b, x, o, e, arena, cigar) == expected);
+            REQUIRE(cigar_penalty(cigar, a, b, x, o, e) == -expected);
+            REQUIRE(wfa::wavefront_simd(a, b, x, o, e, arena, cigar_simd) == expected);
+            REQUIRE(cigar_penalty(cigar_simd, a, b, x, o, e) == -expected);
+        }
+    }
+}
+
+TEST_CASE("Bidirectional wfa::wavefront_bidirectional") {
+    int x = 4, o = 6, e = 2; // Default penalty values
+    wfa::bidirectional_arena_t arena;
+    wfa::wavefront_arena_t reference_arena;
+    std::string cigar;
+
+    SECTION("Short Sequences Align Directly") {
+        REQUIRE(wfa::wavefront_bidirectional("GATTACA", "GACTACA", x, o, e, arena, cigar) == -4);
+        REQUIRE(cigar == "MMXMMMM");
+        REQUIRE(wfa::wavefront_bidirectional("AAAAAA", "AA", x, o, e, arena) == -14);
+        REQUIRE(wfa::wavefront_bidirectional("", "AGCT", x, o, e, arena, cigar) == -14);
+        REQUIRE(cigar == "IIII");
+    }
+
+    SECTION("Long Gap Across The Meeting Point") {
+        std::string a = std::string(400, 'A') + std::string(400, 'C');
+        std::string b = std::string(400, 'A') + std::string(300, 'G') + std::string(400, 'C');
+        int32_t expected = wfa::wavefront(a, b, x, o, e, reference_arena);
+        REQUIRE(expected == -(o + 300 * e));
+        REQUIRE(wfa::wavefront_bidirectional(a, b, x, o, e, arena, cigar) == expected);
+        REQUIRE(cigar_penalty(cigar, a, b, x, o, e) == -expected);
+    }
+
+    SECTION("Random Sequences Above The Fallback Score") {
+        auto sequences = wfa::modify_sequences(2000, 10, 0.1);
+        for (const auto& [a, b] : sequences) {
+            int32_t expected = wfa::wavefront_simd(a, b, x, o, e, reference_arena);
+            REQUIRE(-expected > wfa::bidirectional_fallback_score);
+            REQUIRE(wfa::wavefront_bidirectional(a, b, x, o, e, arena) == expected);
+            REQUIRE(wfa::wavefront_bidirectional(a, b, x, o, e, arena, cigar) == expected);
+            REQUIRE(cigar_penalty(cigar, a, b, x, o, e) == -expected);
+        }
+    }
+}
+
+TEST_CASE("Piggyback traceback of wfa::wavefront_piggyback and wfa::wavefront_simd_piggyback") {
+    int x = 4, o = 6, e = 2; // Default penalty values
+    wfa::piggyback_arena_t arena;
+    wfa::wavefront_arena_t reference_arena;
+    std::string cigar;
+
+    SECTION("Short Sequences") {
+        REQUIRE(wfa::wavefront_piggyback("GATTACA", "GACTACA", x, o, e, arena, cigar) == -4);
+        REQUIRE(cigar == "MMXMMMM");
+        REQUIRE(wfa::wavefront_simd_piggyback("AAAAAA", "AA", x, o, e, arena, cigar) == -14);
+        REQUIRE(cigar_penalty(cigar, "AAAAAA", "AA", x, o, e) == 14);
+        REQUIRE(wfa::wavefront_piggyback("", "", x, o, e, arena, cigar) == 0);
+        REQUIRE(cigar.empty());
+    }
+
+    SECTION("Gap Extensions Are Not Split By Matches") {
+        // Every base of the inserted run also matches the base after it, so the traceback must not look for matches inside the gap
+        REQUIRE(wfa::wavefront_piggyback("ACGT", "ACCCCGT", x, o, e, arena, cigar) == -(o + 3 * e));
+        REQUIRE(cigar_penalty(cigar, "ACGT", "ACCCCGT", x, o, e) == o + 3 * e);
+    }
+
+    SECTION("Random Sequences Spanning Many Blocks") {
+        auto sequences = wfa::modify_sequences(2000, 10, 0.1);
+        for (const auto& [a, b] : sequences) {
+            int32_t expected = wfa::wavefront_simd(a, b, x, o, e, reference_arena);
+            REQUIRE(wfa::wavefront_piggyback(a, b, x, o, e, arena, cigar) == expected);
+            REQUIRE(cigar_penalty(cigar, a, b, x, o, e) == -expected);
+            REQUIRE(wfa::wavefront_simd_piggyback(a, b, x, o, e, arena, cigar) == expected);
+            REQUIRE(cigar_penalty(cigar, a, b, x, o, e) == -expected);
+        }
+    }
+}
+
+TEST_CASE("Adaptive wavefront reduction") {
+    int x = 4, o = 6, e = 2; // Default penalty values
+    wfa::wavefront_arena_t arena;
+    auto sequences = wfa::modify_sequences(500, 20, 0.2);
+
+    SECTION("Unreachable Threshold Matches The Exact Score") {
+        wfa::reduction_t reduction{ 10, 1 << 30 };
+        for (const auto& [a, b] : sequences) {
+            int32_t expected = wfa::wavefront(a, b, x, o, e, arena);
+            REQUIRE(wfa::wavefront(a, b, x, o, e, arena, reduction) == expected);
+            REQUIRE(wfa::wavefront_simd(a, b, x, o, e, arena, reduction) == expected);
+        }
+
+        // Seeded pairs of unequal lengths with long indels, whose match offsets run past the ends of the sequences while gaps on the same diagonals are still inside
+        wfa::read_model_t model = wfa::error_model(300, 0.15, 4);
+        model.length_model = wfa::length_model_t::uniform;
+        model.length_spread = 100;
+        model.long_indel_rate = 0.005;
+        model.long_indel_length = 40;
+        auto pairs = wfa::generate_pairs(model, 40, 1);
+        for (size_t i = 0; i < pairs.size(); ++i) {
+            auto [a, b] = pairs[i];
+            int32_t expected = wfa::wavefront(a, b, x, o, e, arena);
+            REQUIRE(wfa::wavefront(a, b, x, o, e, arena, reduction) == expected);
+            REQUIRE(wfa::wavefront_simd(a, b, x, o, e, arena, reduction) == expected);
+        }
+    }
+
+    SECTION("Gap Inside The Sequences Past A Match Outside Them") {
+        // The match offset of the optimal diagonal steps past the end of a while its insertion is still inside both sequences
+        std::string a = "ACCA";
+        std::string b = "CAAACAAACAAAAACAAACACCAAC";
+        wfa::reduction_t reduction{ 10, 1 << 29 };
+        std::string cigar;
+        int32_t expected = wfa::naive(a, b, 1, 4, 1);
+        REQUIRE(expected == -28);
+        REQUIRE(wfa::wavefront(a, b, 1, 4, 1, arena) == expected);
+        REQUIRE(wfa::wavefront(a, b, 1, 4, 1, arena, reduction) == expected);
+        REQUIRE(wfa::wavefront_simd(a, b, 1, 4, 1, arena, reduction) == expected);
+    }
+
+    SECTION("Reduced Scores Are Never Better Than Exact") {
+        // A threshold of zero keeps only the diagonals tied for closest, which is as aggressive as the heuristic gets
+        for (wfa::reduction_t reduction : { wfa::reduction_t{}, wfa::reduction_t{ 1, 0 } }) {
+            for (const auto& [a, b] : sequences) {
+                int32_t expected = wfa::wavefront(a, b, x, o, e, arena);
+                int32_t reduced = wfa::wavefront(a, b, x, o, e, arena, reduction);
+                REQUIRE(reduced <= expected);
+                REQUIRE(wfa::wavefront_simd(a, b, x, o, e, arena, reduction) == reduced);
+            }
+        }
+    }
+}
+
+TEST_CASE("Batch wfa::wavefront_batch") {
+    int x = 4, o = 6, e = 2; // Default penalty values
+    wfa::batch_arena_t arena;
+    wfa::wavefront_arena_t reference_arena;
+
+    SECTION("Pairs Of Different Lengths Share A Group") {
+        std::vector<std::pair<std::string, std::string>> pairs = {
+            { "GATTACA", "GATTACA" },
+            { "GATTACA", "GACTACA" },
+            { "AAAAAA", "AA" },
+            { "", "AGCT" },
+            { "", "" },
+        };
+        std::vector<int32_t> scores(pairs.size());
+        wfa::wavefront_batch(pairs, x, o, e, arena, scores);
+        REQUIRE(scores == std::vector<int32_t>{ 0, -4, -14, -14, 0 });
+    }
+
+    SECTION("Random Batches Match wfa::wavefront_simd") {
+        // Not a multiple of the vector width, so the last group has lanes without a pair
+        auto sequences = wfa::modify_sequences(250, 8 * static_cast<int32_t>(wfa::simd_type::size()) + 3, 0.1);
+        std::vector<int32_t> scores(sequences.size());
+        wfa::wavefront_batch(sequences, x, o, e, arena, scores);
+        for (size_t i = 0; i < sequences.size(); ++i) {
+            REQUIRE(scores[i] == wfa::wavefront_simd(sequences[i].first, sequences[i].second, x, o, e, reference_arena));
+        }
+    }
+}
+
+TEST_CASE("Parallel wfa::wavefront_parallel") {
+    int x = 4, o = 6, e = 2; // Default penalty values
+    wfa::parallel_arena_t arena;
+    wfa::wavefront_arena_t reference_arena;
+    auto sequences = wfa::modify_sequences(250, 1000, 0.1);
+    std::vector<int32_t> expected(sequences.size());
+    for (size_t i = 0; i < sequences.size(); ++i) {
+        expected[i] = wfa::wavefront_simd(sequences[i].first, sequences[i].second, x, o, e, reference_arena);
+    }
+
+    SECTION("Every Thread Count Matches Serial") {
+        for (int32_t threads : { 1, 3, 8, 0 }) {
+            std::vector<int32_t> scores(sequences.size(), 1);
+            wfa::wavefront_parallel(sequences, x, o, e, arena, scores, threads);
+            REQUIRE(scores == expected);
+        }
+    }
+
+    SECTION("More Threads Than Pairs") {
+        std::vector<int32_t> scores(3, 1);
+        wfa::wavefront_parallel(std::span(sequences).first(3), x, o, e, arena, scores, 16);
+        REQUIRE(std::equal(scores.begin(), scores.end(), expected.begin()));
+        wfa::wavefront_parallel({}, x, o, e, arena, {}, 4);
+    }
+}
+
+TEST_CASE("Packed sequences") {
+    int x = 4, o = 6, e = 2; // Default penalty values
+    wfa::wavefront_arena_t arena;
+
+    SECTION("Ambiguous Bases Keep Their Characters") {
+        std::string sequence = "ACGTNacgtRACGT";
+        wfa::packed_sequence_t packed(sequence);
+        REQUIRE(packed.size() == static_cast<int32_t>(sequence.size()));
+        REQUIRE(packed.ambiguous == std::vector<int32_t>{ 4, 5, 6, 7, 8, 9 });
+        for (int32_t i = 0; i < packed.size(); ++i) {
+            REQUIRE(packed.at(i) == sequence[i]);
+        }
+    }
+
+    SECTION("Match Length Across Word Boundaries") {
+        std::string a(100, 'C');
+        std::string b = a;
+        b[70] = 'G';
+        wfa::packed_sequence_t packed_a(a);
+        wfa::packed_sequence_t packed_b(b);
+        REQUIRE(wfa::match_length(packed_a, 0, packed_b, 0) == 70);
+        REQUIRE(wfa::match_length(packed_a, 5, packed_b, 5) == 65);
+        REQUIRE(wfa::match_length(packed_a, 71, packed_b, 71) == 29);
+        REQUIRE(wfa::match_length(packed_a, 100, packed_b, 0) == 0);
+        // N is packed as A, but still only matches another N
+        REQUIRE(wfa::match_length(wfa::packed_sequence_t("ACNA"), 0, wfa::packed_sequence_t("ACAA"), 0) == 2);
+        REQUIRE(wfa::match_length(wfa::packed_sequence_t("ACNA"), 0, wfa::packed_sequence_t("ACNA"), 0) == 4);
+    }
+
+    SECTION("Scores Match The Unpacked Sequences") {
+        auto sequences = wfa::modify_sequences(500, 20, 0.05);
+        sequences.emplace_back("ACGTNNNNACGTACGT", "ACGTACGTACGTNNNN");
+        sequences.emplace_back("", "ACGT");
+        for (const auto& [a, b] : sequences) {
+            wfa::packed_sequence_t packed_a(a);
+            wfa::packed_sequence_t packed_b(b);
+            int32_t expected = wfa::wavefront_simd(a, b, x, o, e, arena);
+            REQUIRE(wfa::wavefront(packed_a, packed_b, x, o, e, arena) == expected);
+            REQUIRE(wfa::wavefront_simd(packed_a, packed_b, x, o, e, arena) == expected);
+        }
+    }
+}
+
+TEST_CASE("Match length kernels") {
+    SECTION("Every Length And Mismatch Position") {
+        // Covers the full registers, the reread tails and runs shorter than a word
+        for (int32_t length = 0; length <= 140; ++length) {
+            std::string a(length, 'A');
+            for (int32_t mismatch = 0; mismatch <= length; ++mismatch) {
+                std::string b = a;
+                if (mismatch < length) {
+                    b[mismatch] = 'C';
+                }
+                REQUIRE(wfa::match_length(a, 0, b, 0) == mismatch);
+                REQUIRE(wfa::match_length_simd(a, 0, b, 0) == mismatch);
+            }
+        }
+    }
+
+    SECTION("Different Offsets And Lengths") {
+        std::string a = "GATTACA" + std::string(90, 'T') + "G";
+        std::string b = std::string(90, 'T') + "CG";
+        REQUIRE(wfa::match_length(a, 7, b, 0) == 90);
+        REQUIRE(wfa::match_length_simd(a, 7, b, 0) == 90);
+        REQUIRE(wfa::match_length(a, 8, b, 0) == 89);
+        REQUIRE(wfa::match_length_simd(a, 8, b, 0) == 89);
+        REQUIRE(wfa::match_length_simd(a, 7, b, 1) == 89);
+        REQUIRE(wfa::match_length_simd(a, 98, b, 0) == 0);
+        REQUIRE(wfa::match_length_simd(a, 0, b, 92) == 0);
+    }
+}
+
+TEST_CASE("Score-only ring of wavefronts") {
+    wfa::wavefront_arena_t arena;
+    std::string cigar;
+
+    SECTION("Scores Match Keeping Every Wavefront") {
+        auto sequences = wfa::modify_sequences(300, 20, 0.2);
+        for (auto [x, o, e] : { std::tuple{ 4, 6, 2 }, std::tuple{ 1, 0, 1 }, std::tuple{ 7, 2, 3 } }) {
+            for (const auto& [a, b] : sequences) {
+                int32_t expected = wfa::wavefront(a, b, x, o, e, arena, cigar);
+                REQUIRE(wfa::wavefront(a, b, x, o, e, arena) == expected);
+                REQUIRE(wfa::wavefront_simd(a, b, x, o, e, arena) == expected);
+            }
+        }
+    }
+
+    SECTION("Memory Does Not Grow With The Score") {
+        auto sequences = wfa::modify_sequences(2000, 1, 0.3);
+        const auto& [a, b] = sequences.front();
+        wfa::wavefront_arena_t full;
+        wfa::wavefront_simd(a, b, 4, 6, 2, full, cigar);
+        wfa::wavefront_simd(a, b, 4, 6, 2, arena);
+        REQUIRE(arena.capacity() * 4 < full.capacity());
+    }
+}
+
+TEST_CASE("Penalties fixed at compile time") {
+    wfa::wavefront_arena_t arena;
+    auto sequences = wfa::modify_sequences(200, 20, 0.1);
+    for (const auto& [a, b] : sequences) {
+        REQUIRE(wfa::wavefront<4, 6, 2>(a, b, arena) == wfa::naive(a, b, 4, 6, 2));
+        REQUIRE(wfa::wavefront_simd<4, 6, 2>(a, b, arena) == wfa::wavefront(a, b, 4, 6, 2, arena));
+        REQUIRE(wfa::wavefront<2, 3, 1>(a, b, arena) == wfa::naive(a, b, 2, 3, 1));
+        REQUIRE(wfa::wavefront_simd<2, 3, 1>(a, b, arena) == wfa::wavefront_simd(a, b, 2, 3, 1, arena));
+        // A set without an instantiation takes the generic path
+        REQUIRE(wfa::wavefront_simd(a, b, 3, 5, 2, arena) == wfa::naive(a, b, 3, 5, 2));
+    }
+}
+
+TEST_CASE("Gap-linear and edit-distance wavefronts") {
+    wfa::wavefront_arena_t arena;
+
+    SECTION("Edge Cases") {
+        REQUIRE(wfa::wavefront_edit("", "", arena) == 0);
+        REQUIRE(wfa::wavefront_edit("", "ACG", arena) == -3);
+        REQUIRE(wfa::wavefront_edit_simd("ACG", "", arena) == -3);
+        REQUIRE(wfa::wavefront_edit("kitten", "sitting", arena) == -3);
+        REQUIRE(wfa::wavefront_linear_simd("GATTACA", "GATCACA", 5, 2, arena) == -4);
+    }
+
+    SECTION("Random Sequences Match Naive") {
+        for (double error_rate : { 0.05, 0.3 }) {
+            auto sequences = wfa::modify_sequences(150, 10, error_rate);
+            sequences.emplace_back(std::string(100, 'A'), std::string(40, 'A'));
+            for (const auto& [a, b] : sequences) {
+                int32_t edit = wfa::naive_linear(a, b, 1, 1);
+                REQUIRE(wfa::wavefront_edit(a, b, arena) == edit);
+                REQUIRE(wfa::wavefront_edit_simd(a, b, arena) == edit);
+                for (auto [x, e] : { std::pair{ 4, 2 }, std::pair{ 3, 5 }, std::pair{ 1, 3 } }) {
+                    int32_t expected = wfa::naive_linear(a, b, x, e);
+                    REQUIRE(wfa::wavefront_linear(a, b, x, e, arena) == expected);
+                    REQUIRE(wfa::wavefront_linear_simd(a, b, x, e, arena) == expected);
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("Two-piece gap-affine wavefronts") {
+    wfa::wavefront_arena_t arena;
+
+    SECTION("Long Deletion") {
+        std::string a = "ACGT" + std::string(30, 'G') + "TGCA";
+        std::string b = "ACGTTGCA";
+        wfa::affine2p_penalties_t penalties{ 4, 6, 2, 24, 1 };
+        REQUIRE(wfa::wavefront_affine2p(a, b, penalties, arena) == -54);
+        REQUIRE(wfa::wavefront_affine2p_simd(a, b, penalties, arena) == -54);
+    }
+
+    SECTION("Random Sequences Match Naive") {
+        auto sequences = wfa::modify_sequences(150, 10, 0.1);
+        sequences.emplace_back(std::string(120, 'C'), std::string(30, 'C'));
+        sequences.emplace_back("", "ACGT");
+        for (auto penalties : { wfa::affine2p_penalties_t{ 4, 6, 2, 24, 1 }, wfa::affine2p_penalties_t{ 2, 4, 2, 12, 1 }, wfa::affine2p_penalties_t{ 5, 1, 3, 7, 2 } }) {
+            for (const auto& [a, b] : sequences) {
+                int32_t expected = wfa::naive_affine2p(a, b, penalties.x, penalties.o1, penalties.e1, penalties.o2, penalties.e2);
+                REQUIRE(wfa::wavefront_affine2p(a, b, penalties, arena) == expected);
+                REQUIRE(wfa::wavefront_affine2p_simd(a, b, penalties, arena) == expected);
+            }
+        }
+    }
+}
+
+TEST_CASE("Ends-free wavefronts") {
+    int x = 4, o = 6, e = 2; // Default penalty values
+    wfa::wavefront_arena_t arena;
+
+    SECTION("Overlapping Reads") {
+        // The end of a overlaps the start of b
+        std::string a = "TTTTTTTTTTGATTACAGATTACA";
+        std::string b = "GATTACAGATTACACCCCCCCCCC";
+        wfa::ends_free_t ends{ 10, 0, 0, 10 };
+        REQUIRE(wfa::wavefront_ends_free(a, b, x, o, e, ends, arena) == 0);
+        REQUIRE(wfa::wavefront_ends_free_simd(a, b, x, o, e, ends, arena) == 0);
+        REQUIRE(wfa::wavefront_ends_free(a, b, x, o, e, wfa::ends_free_t{ 0, 0, 0, 0 }, arena) == wfa::wavefront(a, b, x, o, e, arena));
+    }
+
+    SECTION("Random Sequences Match Naive") {
+        auto sequences = wfa::modify_sequences(150, 10, 0.1);
+        sequences.emplace_back(std::string(120, 'C'), std::string(30, 'C'));
+        sequences.emplace_back("", "ACGT");
+        sequences.emplace_back("ACGT", "");
+        for (auto ends : { wfa::ends_free_t{ 0, 0, 0, 0 }, wfa::ends_free_t{ 20, 20, 0, 0 }, wfa::ends_free_t{ 0, 5, 30, 0 }, wfa::ends_free_t{ 200, 200, 200, 200 } }) {
+            for (const auto& [a, b] : sequences) {
+                int32_t expected = wfa::naive_ends_free(a, b, x, o, e, ends.a_begin, ends.a_end, ends.b_begin, ends.b_end);
+                REQUIRE(wfa::wavefront_ends_free(a, b, x, o, e, ends, arena) == expected);
+                REQUIRE(wfa::wavefront_ends_free_simd(a, b, x, o, e, ends, arena) == expected);
+            }
+        }
+    }
+}
+
+TEST_CASE("Extension wavefronts") {
+    int x = 4, o = 6, e = 2; // Default penalty values
+    wfa::wavefront_arena_t arena;
+    std::string p = "ACGTTGCAGGATCCATGACTAGCTAGGCTTACGATCGGATCCTAGCTAGCATCGATCGAT";
+    std::string q = "TTGACCAGTAGGCATCGATGCAAGCTTGACTGACGTACGATCAGGCATTCAGCGATCAGT";
+
+    SECTION("Stops At The End Of The Homology") {
+        std::string a = p + std::string(30, 'C');
+        std::string b = p + std::string(30, 'G');
+        for (bool diagonal : { false, true }) {
+            for (auto extension : { wfa::wavefront_extension(a, b, x, o, e, wfa::drop_t{ 1, 20, diagonal }, arena), wfa::wavefront_extension_simd(a, b, x, o, e, wfa::drop_t{ 1, 20, diagonal }, arena) }) {
+                REQUIRE(extension.score == 120);
+                REQUIRE(extension.a_length == 60);
+                REQUIRE(extension.b_length == 60);
+            }
+        }
+    }
+
+    SECTION("Z-Drop Crosses A Long Gap") {
+        // The 20 base deletion costs 6 + 20 * 2 and earns 20, dropping the score by 26
+        std::string a = p + std::string(20, 'G') + q;
+        std::string b = p + q;
+        wfa::extension_t xdrop = wfa::wavefront_extension(a, b, x, o, e, wfa::drop_t{ 1, 20, false }, arena);
+        REQUIRE(xdrop.score == 120);
+        REQUIRE(xdrop.a_length == 60);
+        wfa::extension_t zdrop = wfa::wavefront_extension_simd(a, b, x, o, e, wfa::drop_t{ 1, 20, true }, arena);
+        REQUIRE(zdrop.score == 214);
+        REQUIRE(zdrop.a_length == 140);
+        REQUIRE(zdrop.b_length == 120);
+    }
+
+    SECTION("Random Sequences Match Naive Without Drops") {
+        auto sequences = wfa::modify_sequences(150, 10, 0.1);
+        sequences.emplace_back("", "ACGT");
+        for (int32_t match : { 1, 3 }) {
+            for (const auto& [a, b] : sequences) {
+                // Larger than any score can fall, so nothing is dropped
+                int32_t threshold = static_cast<int32_t>(a.size() + b.size() + 1) * (match + x + o + e);
+                int32_t expected = wfa::naive_extension(a, b, x, o, e, match);
+                REQUIRE(wfa::wavefront_extension(a, b, x, o, e, wfa::drop_t{ match, threshold, false }, arena).score == expected);
+                REQUIRE(wfa::wavefront_extension_simd(a, b, x, o, e, wfa::drop_t{ match, threshold, true }, arena).score == expected);
+            }
+        }
+    }
+}
+
+TEST_CASE("FASTA and FASTQ reader") {
+    SECTION("Records") {
+        std::string contents = ">r1 description\nGATTACA\n\n>r2\r\nACGT\r\nAC\r\n@q1\nGATACA\n+\nIIIIII\n>empty\n";
+        wfa::sequence_reader_t reader(contents);
+        wfa::sequence_record_t record;
+        REQUIRE(reader.next(record));
+        REQUIRE(record.name == "r1");
+        REQUIRE(record.sequence == "GATTACA");
+        // Single line sequences are not copied
+        REQUIRE(record.sequence.data() >= contents.data());
+        REQUIRE(record.sequence.data() < contents.data() + contents.size());
+        REQUIRE(reader.next(record));
+        REQUIRE(record.name == "r2");
+        REQUIRE(record.sequence == "ACGTAC");
+        REQUIRE(reader.next(record));
+        REQUIRE(record.name == "q1");
+        REQUIRE(record.sequence == "GATACA");
+        REQUIRE(reader.next(record));
+        REQUIRE(record.name == "empty");
+        REQUIRE(record.sequence.empty());
+        REQUIRE(not reader.next(record));
+        REQUIRE(not reader.failed);
+    }
+
+    SECTION("Malformed Records") {
+        wfa::sequence_record_t record;
+        wfa::sequence_reader_t missing_marker("GATTACA\n");
+        REQUIRE(not missing_marker.next(record));
+        REQUIRE(missing_marker.failed);
+        wfa::sequence_reader_t missing_separator("@q1\nGATTACA\n");
+        REQUIRE(not missing_separator.next(record));
+        REQUIRE(missing_separator.failed);
+    }
+
+    SECTION("Interleaved Pairs") {
+        // Both sequences of each pair are wrapped, so both need the join buffers
+        wfa::pair_reader_t reader(">a1\nGATT\nACA\n>b1\nGAT\nACA\n>a2\nACGT\n>b2\nACGT\n");
+        wfa::sequence_record_t a;
+        wfa::sequence_record_t b;
+        REQUIRE(reader.next(a, b));
+        REQUIRE(a.sequence == "GATTACA");
+        REQUIRE(b.sequence == "GATACA");
+        REQUIRE(reader.next(a, b));
+        REQUIRE(a.name == "a2");
+        REQUIRE(b.name == "b2");
+        REQUIRE(not reader.next(a, b));
+        REQUIRE(not reader.failed());
+    }
+
+    SECTION("Mapped Files") {
+        auto path = std::filesystem::temp_directory_path() / "wfa_tests_reader.fa";
+        {
+            std::ofstream file(path, std::ios::binary);
+            file << ">a\nGATTACA\n";
+        }
+        wfa::mapped_file_t file(path.string());
+        REQUIRE(file.is_open());
+        REQUIRE(file.contents() == ">a\nGATTACA\n");
+        wfa::mapped_file_t moved = std::move(file);
+        REQUIRE(moved.contents() == ">a\nGATTACA\n");
+        REQUIRE(file.contents().empty());
+        std::filesystem::remove(path);
+        REQUIRE(not wfa::mapped_file_t(path.string()).is_open());
+    }
+}
+
+TEST_CASE("Pair datasets") {
+    auto path = (std::filesystem::temp_directory_path() / "wfa_tests_pairs.wfad").string();
+    auto sequences = wfa::modify_sequences(150, 100, 0.1);
+    sequences.emplace_back("", "ACGT");
+
+    SECTION("Round Trip") {
+        for (bool packed : { false, true }) {
+            REQUIRE(wfa::write_dataset(path, sequences, packed));
+            wfa::pair_dataset_t dataset(path);
+            REQUIRE(dataset.is_open());
+            REQUIRE(dataset.packed() == packed);
+            REQUIRE(dataset.size() == sequences.size());
+            REQUIRE(dataset.load() == sequences);
+            if (not packed) {
+                for (size_t i = 0; i < sequences.size(); ++i) {
+                    REQUIRE(dataset[i].first == sequences[i].first);
+                    REQUIRE(dataset[i].second == sequences[i].second);
+                }
+            }
+        }
+    }
+
+    SECTION("From A Reader") {
+        wfa::pair_reader_t reader(">a\nGATT\nACA\n>b\nGATACA\n");
+        REQUIRE(wfa::write_dataset(path, reader));
+        wfa::pair_dataset_t dataset(path);
+        REQUIRE(dataset.size() == 1);
+        REQUIRE(dataset[0].first == "GATTACA");
+        REQUIRE(dataset[0].second == "GATACA");
+    }
+
+    SECTION("Invalid Files") {
+        std::vector<std::pair<std::string, std::string>> ambiguous = { { "ACGN", "ACGT" } };
+        REQUIRE(not wfa::write_dataset(path, ambiguous, true));
+        REQUIRE(wfa::write_dataset(path, sequences));
+        std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+        REQUIRE(not wfa::pair_dataset_t(path).is_open());
+        {
+            std::ofstream file(path, std::ios::binary);
+            file << ">a\nGATTACA\n";
+        }
+        REQUIRE(not wfa::pair_dataset_t(path).is_open());
+    }
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Alignment output") {
+    std::string cigar = "MMMDMMMXM";
+    wfa::alignment_record_t record{ "ref", "read", 9, 8, -14, cigar, "GATACAAA" };
+
+    SECTION("Formats") {
+        fmt::memory_buffer out;
+        wfa::append_cigar(out, cigar);
+        REQUIRE(fmt::to_string(out) == "3=1D3=1X1=");
+
+        out.clear();
+        wfa::format_paf(out, record);
+        REQUIRE(fmt::to_string(out) == "read\t8\t0\t8\t+\tref\t9\t0\t9\t7\t9\t255\tNM:i:2\tAS:i:-14\tcg:Z:3=1D3=1X1=\n");
+
+        out.clear();
+        wfa::format_sam(out, record);
+        REQUIRE(fmt::to_string(out) == "read\t0\tref\t1\t255\t3=1D3=1X1=\t*\t0\t0\tGATACAAA\t*\tNM:i:2\tAS:i:-14\n");
+
+        // Score-only alignments leave out everything that needs the cigar
+        record.cigar = "";
+        record.b_sequence = "";
+        out.clear();
+        wfa::format_sam(out, record);
+        REQUIRE(fmt::to_string(out) == "read\t0\tref\t1\t255\t*\t*\t0\t0\t*\t*\tAS:i:-14\n");
+    }
+
+    SECTION("Ordered Writer") {
+        auto path = std::filesystem::temp_directory_path() / "wfa_tests_output.txt";
+        std::FILE* file = std::fopen(path.string().c_str(), "wb");
+        REQUIRE(file != nullptr);
+        {
+            // Few pending blocks, so submitting threads have to wait on the writer, and uneven work makes them finish out of order
+            wfa::ordered_writer_t writer(file, 2);
+            std::atomic<size_t> next = 0;
+            std::vector<std::jthread> pool;
+            for (size_t thread = 0; thread < 4; ++thread) {
+                pool.emplace_back([&] {
+                    for (size_t index = next++; index < 400; index = next++) {
+                        if (index % 7 == 0) {
+                            std::this_thread::sleep_for(std::chrono::microseconds(200));
+                        }
+                        fmt::memory_buffer block;
+                        fmt::format_to(std::back_inserter(block), "{}\n", index);
+                        writer.submit(index, std::move(block));
+                    }
+                });
+            }
+        }
+        std::fclose(file);
+        std::ifstream written(path);
+        size_t expected = 0;
+        for (std::string line; std::getline(written, line); ++expected) {
+            REQUIRE(line == std::to_string(expected));
+        }
+        REQUIRE(expected == 400);
+        std::filesystem::remove(path);
+    }
+}
+
+TEST_CASE("Engine statistics") {
+    wfa::reset_stats();
+    std::string a = "GATTACAGATTACAGATTACAGATTACAGATTACAGATTACAGATTACAGATTACA";
+    std::string b = "GATTACAGATCACAGATTACAGATTAAGATTACAGATTTACAGATTACAGATTACA";
+    //A thread of its own, so the counters of earlier tests on the main thread stay out of the way
+    std::thread([&] {
+        wfa::wavefront_arena_t arena;
+        REQUIRE(wfa::wavefront(a, b, 4, 6, 2, arena) == wfa::wavefront_simd(a, b, 4, 6, 2, arena));
+    }).join();
+
+    std::vector<wfa::stats_t> threads = wfa::collect_stats();
+    wfa::stats_t total;
+    for (const auto& thread : threads) {
+        total += thread;
+    }
+    REQUIRE(wfa::stats_json().starts_with(wfa::stats_enabled ? "{\"enabled\": true" : "{\"enabled\": false"));
+    if constexpr (wfa::stats_enabled) {
+        //Threads register on their first count, so the worker's counters come last
+        REQUIRE(not threads.empty());
+        const wfa::stats_t& worker = threads.back();
+        REQUIRE(worker.alignments == 2);
+        REQUIRE(total.alignments == 2);
+        //Both engines take the same steps, and only the SIMD one computes diagonals a vector at a time
+        REQUIRE(worker.scores % 2 == 0);
+        REQUIRE(worker.scores > 0);
+        REQUIRE(worker.scalar_diagonals + worker.vector_diagonals > worker.scores);
+        REQUIRE(worker.extended_diagonals > 0);
+        REQUIRE(worker.characters >= 2 * a.size());
+        REQUIRE(worker.vector_characters + worker.tail_characters > 0);
+        REQUIRE(worker.arena_peak > 0);
+    }
+    else {
+        REQUIRE(threads.empty());
+    }
+}
+
+TEST_CASE("Read generator") {
+    SECTION("Deterministic") {
+        wfa::read_model_t model = wfa::error_model(300, 0.1, 7);
+        model.length_model = wfa::length_model_t::normal;
+        model.length_spread = 50;
+        model.long_indel_rate = 0.002;
+        //Not a whole number of chunks, so the last one is partial
+        auto one = wfa::generate_pairs(model, 2500, 1);
+        auto many = wfa::generate_pairs(model, 2500, 4);
+        REQUIRE(one.size() == 2500);
+        REQUIRE(one.bases == many.bases);
+        REQUIRE(one.offsets == many.offsets);
+        REQUIRE(one.offsets.back() == one.bases.size());
+
+        model.seed = 8;
+        REQUIRE(wfa::generate_pairs(model, 2500, 2).bases != one.bases);
+        REQUIRE(wfa::generate_pairs(model, 0).size() == 0);
+    }
+
+    SECTION("Error types") {
+        wfa::read_model_t model;
+        model.length = 200;
+        auto exact = wfa::generate_pairs(model, 50);
+        for (size_t i = 0; i < exact.size(); ++i) {
+            REQUIRE(exact[i].first.size() == 200);
+            REQUIRE(exact[i].first == exact[i].second);
+        }
+
+        model.mismatch_rate = 0.1;
+        auto mismatches = wfa::generate_pairs(model, 50);
+        size_t differences = 0;
+        for (size_t i = 0; i < mismatches.size(); ++i) {
+            auto [a, b] = mismatches[i];
+            REQUIRE(a.size() == b.size());
+            for (size_t j = 0; j < a.size(); ++j) {
+                differences += a[j] != b[j];
+            }
+        }
+        REQUIRE(differences > 500);
+        REQUIRE(differences < 1500);
+
+        model.mismatch_rate = 0.0;
+        model.deletion_rate = 0.05;
+        auto deletions = wfa::generate_pairs(model, 50);
+        model.deletion_rate = 0.0;
+        model.insertion_rate = 0.05;
+        auto insertions = wfa::generate_pairs(model, 50);
+        for (size_t i = 0; i < 50; ++i) {
+            REQUIRE(deletions[i].second.size() <= 200);
+            REQUIRE(insertions[i].second.size() >= 200);
+        }
+        REQUIRE(deletions.bases.size() < 50 * 400);
+        REQUIRE(insertions.bases.size() > 50 * 400);
+    }
+
+    SECTION("Lengths") {
+        wfa::read_model_t model;
+        model.length = 100;
+        model.length_model = wfa::length_model_t::uniform;
+        model.length_spread = 20;
+        auto pairs = wfa::generate_pairs(model, 500);
+        size_t shortest = 1000, longest = 0;
+        for (size_t i = 0; i < pairs.size(); ++i) {
+            shortest = std::min(shortest, pairs[i].first.size());
+            longest = std::max(longest, pairs[i].first.size());
+        }
+        REQUIRE(shortest >= 80);
+        REQUIRE(longest <= 120);
+        REQUIRE(longest - shortest > 30);
+    }
+
+    SECTION("Alignment") {
+        wfa::read_model_t model = wfa::error_model(250, 0.15, 3);
+        model.homopolymer_factor = 4.0;
+        model.long_indel_rate = 0.004;
+        model.long_indel_length = 10;
+        auto pairs = wfa::generate_pairs(model, 40);
+        wfa::wavefront_arena_t arena;
+        for (size_t i = 0; i < pairs.size(); ++i) {
+            auto [a, b] = pairs[i];
+            int32_t expected = wfa::naive(a, b, 4, 6, 2);
+            REQUIRE(wfa::wavefront(a, b, 4, 6, 2, arena) == expected);
+            REQUIRE(wfa::wavefront_simd(a, b, 4, 6, 2, arena) == expected);
+        }
+
+        auto path = (std::filesystem::temp_directory_path() / "wfa_tests_generated.wfad").string();
+        REQUIRE(wfa::write_dataset(path, pairs));
+        {
+            wfa::pair_dataset_t dataset(path);
+            REQUIRE(dataset.size() == pairs.size());
+            for (size_t i = 0; i < pairs.size(); ++i) {
+                REQUIRE(dataset[i] == pairs[i]);
+            }
+        }
+        std::filesystem::remove(path);
+    }
+}
+
+TEST_CASE("Wavefront guard cells") {
+    wfa::wavefront_arena_t arena;
+
+    SECTION("Guards Read As Out Of Range") {
+        wfa::wavefront_t wavefront(arena);
+        auto& entry = wavefront.insert(-5, 7);
+        for (int32_t column = 0; column < 3; ++column) {
+            for (int32_t k = entry.low; k <= entry.high; ++k) {
+                entry.set(column, k, 100 * column + k + 5);
+            }
+        }
+        wavefront.shrink(-2, 4);
+        for (int32_t column = 0; column < 3; ++column) {
+            for (int32_t k = -2 - wfa::wavefront_guard; k <= 4 + wfa::wavefront_guard; ++k) {
+                int32_t expected = k < -2 or k > 4 ? -1 : 100 * column + k + 5;
+                REQUIRE(entry.lookup(column, k) == expected);
+                REQUIRE(entry.start_ptr(column)[k + 2] == expected);
+            }
+            for (int32_t k = -30; k < 30; ++k) {
+                wfa::simd_type values = wfa::simd_lookup(entry, column, k, 1);
+                for (int32_t i = 0; i < static_cast<int32_t>(wfa::simd_type::size()); ++i) {
+                    REQUIRE(values[i] == entry.lookup(column, k + 1 + i));
+                }
+            }
+        }
+    }
+
+    SECTION("Narrow Sources Fall Back To Checked Loads") {
+        // Seeded, with long indels, so the gap wavefronts drift far from the mismatch one and a failure replays
+        wfa::reduction_t reduction{ 4, 2 };
+        wfa::read_model_t model = wfa::error_model(500, 0.25, 24);
+        model.long_indel_rate = 0.002;
+        model.long_indel_length = 30;
+        auto pairs = wfa::generate_pairs(model, 20, 1);
+        for (size_t i = 0; i < pairs.size(); ++i) {
+            auto [a, b] = pairs[i];
+            REQUIRE(wfa::wavefront_simd(a, b, 4, 6, 2, arena, reduction) == wfa::wavefront(a, b, 4, 6, 2, arena, reduction));
+            REQUIRE(wfa::wavefront_simd(a, b, 4, 6, 2, arena) == wfa::wavefront(a, b, 4, 6, 2, arena));
+        }
+    }
+}
+
+// Puts back the process-wide kernel level when a test exits, even through a failed REQUIRE
+struct simd_level_guard_t {
+    wfa::simd_level_t level = wfa::simd_level();
+    ~simd_level_guard_t() { wfa::set_simd_level(level); }
+};
+
+TEST_CASE("Extend kernel dispatch") {
+    simd_level_guard_t guard;
+    wfa::simd_level_t startup = guard.level;
+    wfa::simd_level_t detected = wfa::detect_simd_level();
+    REQUIRE(startup <= detected);
+
+    SECTION("Level Names") {
+        for (auto level : { wfa::simd_level_t::scalar, wfa::simd_level_t::sse2, wfa::simd_level_t::avx2, wfa::simd_level_t::avx512bw }) {
+            wfa::simd_level_t parsed;
+            REQUIRE(wfa::parse_simd_level(wfa::simd_level_name(level), parsed));
+            REQUIRE(parsed == level);
+        }
+        wfa::simd_level_t parsed;
+        REQUIRE(not wfa::parse_simd_level("avx", parsed));
+    }
+
+    SECTION("Every Supported Level Matches") {
+        REQUIRE(wfa::set_simd_level(wfa::simd_level_t::avx512bw) == detected);
+        wfa::read_model_t model = wfa::error_model(300, 0.1, 25);
+        model.long_indel_rate = 0.002;
+        auto pairs = wfa::generate_pairs(model, 10, 1);
+        wfa::wavefront_arena_t arena;
+        for (auto level : { wfa::simd_level_t::scalar, wfa::simd_level_t::sse2, wfa::simd_level_t::avx2, wfa::simd_level_t::avx512bw }) {
+            if (level > detected) {
+                continue;
+            }
+            REQUIRE(wfa::set_simd_level(level) == level);
+            REQUIRE(wfa::simd_level() == level);
+            for (int32_t length = 0; length <= 140; length += 3) {
+                std::string a(length, 'A');
+                for (int32_t mismatch = 0; mismatch <= length; ++mismatch) {
+                    std::string b = a;
+                    if (mismatch < length) {
+                        b[mismatch] = 'C';
+                    }
+                    REQUIRE(wfa::match_length_simd(a, 0, b, 0) == mismatch);
+                }
+            }
+            for (size_t i = 0; i < pairs.size(); ++i) {
+                auto [a, b] = pairs[i];
+                REQUIRE(wfa::wavefront_simd(a, b, 4, 6, 2, arena) == wfa::wavefront(a, b, 4, 6, 2, arena));
+            }
+        }
+    }
+}
+
+TEST_CASE("Alignment bounded by a maximum score") {
+    int x = 4, o = 6, e = 2; // Default penalty values
+    wfa::wavefront_arena_t arena;
+    auto sequences = wfa::modify_sequences(200, 20, 0.1);
+    sequences.emplace_back("GATTACA", "GATTACA");
+
+    for (const auto& [a, b] : sequences) {
+        int32_t score = -wfa::wavefront(a, b, x, o, e, arena);
+        // A bound at the score still aligns, one below it does not
+        REQUIRE(wfa::wavefront(a, b, x, o, e, arena, score) == -score);
+        REQUIRE(wfa::wavefront_simd(a, b, x, o, e, arena, score) == -score);
+        if (score > 0) {
+            REQUIRE(wfa::wavefront(a, b, x, o, e, arena, score - 1) == wfa::score_exceeded);
+            REQUIRE(wfa::wavefront_simd(a, b, x, o, e, arena, score - 1) == wfa::score_exceeded);
+        }
+    }
+    // The arena is reset after an exceeded alignment, so it can be reused straight away
+    REQUIRE(wfa::wavefront_simd("ACGT", "TGCA", x, o, e, arena, 0) == wfa::score_exceeded);
+    REQUIRE(arena.current_block == 0);
+    REQUIRE(arena.current_index == 0);
+    REQUIRE(wfa::wavefront_simd("ACGT", "ACGT", x, o, e, arena, 0) == 0);
+}